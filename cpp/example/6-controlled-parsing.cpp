@@ -86,7 +86,7 @@ int main (int argc, char ** argv)
 		parseContext.Run();
 	}
 	catch (ParseFailedException const & e) {
-		std::cout << e.message << "\n";
+		std::cout << e.Message() << "\n";
 		printHelp();
 		return 1;
 	}
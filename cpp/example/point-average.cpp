@@ -11,15 +11,7 @@ using namespace lambda_options::with_char;
 //////////////////////////////////////////////////////////////////////////
 
 
-class Point {
-public:
-	Point (float x, float y, float z)
-		: x(x)
-		, y(y)
-		, z(z)
-	{}
-
-public:
+struct Point {
 	float x;
 	float y;
 	float z;
@@ -29,24 +21,21 @@ public:
 namespace lambda_options
 {
 	template <typename Char>
-	struct RawParser<Char, Point> {
-		bool operator() (ParseState<Char> & parseState, void * rawMemory)
-		{
-			Maybe<std::array<float, 3>> maybeVals;
-			if (Parse<Char, std::array<float, 3>>(parseState, maybeVals)) {
-				auto & vals = *maybeVals;
-				new (rawMemory) Point(vals[0], vals[1], vals[2]);
-				return true;
-			}
-			return false;
-		}
-	};
+	struct RawParser<Char, Point> : public AggregateParser<Char, Point,
+		LAMBDA_OPTIONS_MEMBER(Point, x),
+		LAMBDA_OPTIONS_MEMBER(Point, y),
+		LAMBDA_OPTIONS_MEMBER(Point, z)> {};
+
+
+	// Lets overloads taking a Point be skipped when fewer than three arguments remain.
+	template <typename Char>
+	struct RawParserTraits<Char, Point> : public RawParser<Char, Point>::Traits {};
 }
 
 
 Point ComputeAverage (std::vector<Point> const & points)
 {
-	Point average(0, 0, 0);
+	Point average = { 0, 0, 0 };
 	for (Point const & p : points) {
 		average.x += p.x;
 		average.y += p.y;
@@ -76,14 +65,15 @@ public:
 		kwPoint.argText = "x y z";
 		kwPoint.text = "Add a point to contribute to displayed point average.";
 		opts.AddOption(kwPoint, [&] (Point p) {
-			points.emplace_back(p.x, p.y, p.z);
+			points.push_back(p);
 		});
 
 		Keyword kwWeightedPoint("point", "p");
 		kwWeightedPoint.argText = "w x y z";
 		kwWeightedPoint.text = "Add a weighted point to contribute to displayed point average.";
 		opts.AddOption(kwWeightedPoint, [&] (float weight, Point p) {
-			points.emplace_back(weight * p.x, weight * p.y, weight * p.z);
+			Point weighted = { weight * p.x, weight * p.y, weight * p.z };
+			points.push_back(weighted);
 		});
 	}
 
@@ -131,7 +121,7 @@ public:
 
 	void PrintBadArgs (ParseFailedException const & e) const
 	{
-		std::cout << e.message << "\n";
+		std::cout << e.Message() << "\n";
 		PrintHelp();
 	}
 
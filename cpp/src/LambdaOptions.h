@@ -28,6 +28,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cctype>
 #include <cstdio>
 #include <cstring>
@@ -39,6 +40,8 @@
 #include <new>
 #include <stdexcept>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -46,6 +49,69 @@
 //////////////////////////////////////////////////////////////////////////
 
 
+#ifndef LAMBDA_OPTIONS_CPP17
+#	if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#		define LAMBDA_OPTIONS_CPP17 1
+#	else
+#		define LAMBDA_OPTIONS_CPP17 0
+#	endif
+#endif
+
+
+#ifndef LAMBDA_OPTIONS_VARIADIC_TEMPLATES
+#	if !_MSC_VER || _MSC_VER >= 1800
+#		define LAMBDA_OPTIONS_VARIADIC_TEMPLATES 1
+#	else
+#		define LAMBDA_OPTIONS_VARIADIC_TEMPLATES 0
+#	endif
+#endif
+
+
+// Builds without exception support (e.g. -fno-exceptions) report every error through return values.
+#ifndef LAMBDA_OPTIONS_NO_THROW
+#	if !defined(__cpp_exceptions) && !defined(__EXCEPTIONS) && !defined(_CPPUNWIND)
+#		define LAMBDA_OPTIONS_NO_THROW
+#	endif
+#endif
+
+
+#if LAMBDA_OPTIONS_CPP17
+#	include <optional>
+#	include <variant>
+#endif
+
+
+#ifdef LAMBDA_OPTIONS_FILE_MAPPING
+#	if _WIN32
+#		ifndef WIN32_LEAN_AND_MEAN
+#			define WIN32_LEAN_AND_MEAN
+#			define LAMBDA_OPTIONS_UNDEF_WIN32_LEAN_AND_MEAN
+#		endif
+#		ifndef NOMINMAX
+#			define NOMINMAX
+#			define LAMBDA_OPTIONS_UNDEF_NOMINMAX
+#		endif
+#		include <windows.h>
+#		ifdef LAMBDA_OPTIONS_UNDEF_WIN32_LEAN_AND_MEAN
+#			undef WIN32_LEAN_AND_MEAN
+#			undef LAMBDA_OPTIONS_UNDEF_WIN32_LEAN_AND_MEAN
+#		endif
+#		ifdef LAMBDA_OPTIONS_UNDEF_NOMINMAX
+#			undef NOMINMAX
+#			undef LAMBDA_OPTIONS_UNDEF_NOMINMAX
+#		endif
+#	else
+#		include <fcntl.h>
+#		include <sys/mman.h>
+#		include <sys/stat.h>
+#		include <unistd.h>
+#	endif
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////
+
+
 #if _MSC_VER
 #	pragma warning (push)
 #	pragma warning (disable: \
@@ -96,9 +162,7 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 			(void) truth;
 #else
 			if (!truth) {
-				char msg[1024];
-				std::sprintf(msg, "Assert failed in '%s' on line %u.", __FILE__, line);
-				throw Exception(msg);
+				throw Exception("Assert failed in '" __FILE__ "' on line " + std::to_string(line) + ".");
 			}
 #endif
 		}
@@ -204,12 +268,14 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 		template <>
 		struct StringLiteral<char> {
 			static char const * xX () { return "xX"; };
+			static char const * no () { return "no-"; };
 		};
 
 
 		template <>
 		struct StringLiteral<wchar_t> {
 			static wchar_t const * xX () { return L"xX"; };
+			static wchar_t const * no () { return L"no-"; };
 		};
 
 
@@ -222,6 +288,62 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	class Any {};
 
 
+	// A non-owning view of contiguous objects.
+	template <typename T>
+	class Span {
+	public:
+		Span ()
+			: data(nullptr)
+			, size(0)
+		{}
+
+		Span (T * data, size_t size)
+			: data(data)
+			, size(size)
+		{}
+
+		template <size_t N>
+		Span (T (&array)[N])
+			: data(array)
+			, size(N)
+		{}
+
+		T * Data () const
+		{
+			return data;
+		}
+
+		size_t Size () const
+		{
+			return size;
+		}
+
+		bool Empty () const
+		{
+			return size == 0;
+		}
+
+		T & operator[] (size_t index) const
+		{
+			return data[index];
+		}
+
+		T * begin () const
+		{
+			return data;
+		}
+
+		T * end () const
+		{
+			return data + size;
+		}
+
+	private:
+		T * data;
+		size_t size;
+	};
+
+
 	template <typename Char>
 	class ParseState;
 
@@ -348,6 +470,22 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	};
 
 
+	// Thrown in deterministic mode when an option could start with the same token as another option.
+	template <typename Char>
+	class AmbiguousOptionException : public OptionException {
+	public:
+		typedef std::basic_string<Char> String;
+
+		AmbiguousOptionException (String const & name1, String const & name2)
+			: OptionException("Cannot add an option whose first token overlaps another option in deterministic mode.")
+			, ambiguousNames(name1, name2)
+		{}
+
+	public:
+		std::pair<String, String> ambiguousNames;
+	};
+
+
 	class EmptyOptionException : public OptionException {
 	public:
 		EmptyOptionException ()
@@ -356,6 +494,54 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	};
 
 
+	// Thrown when a negatable option's function does not take exactly one bool.
+	class NegatableSignatureException : public OptionException {
+	public:
+		NegatableSignatureException ()
+			: OptionException("Cannot add a negatable option whose function does not take a single bool.")
+		{}
+	};
+
+
+	// Thrown when a counted option's function does not take exactly one integer.
+	class CountedSignatureException : public OptionException {
+	public:
+		CountedSignatureException ()
+			: OptionException("Cannot add a counted option whose function does not take a single integer.")
+		{}
+	};
+
+
+	// Thrown when a collected option's keyword is negatable or counted, which would leave no value to collect.
+	class CollectedKeywordException : public OptionException {
+	public:
+		CollectedKeywordException ()
+			: OptionException("Cannot add a collected option whose keyword is negatable or counted.")
+		{}
+	};
+
+
+	// Thrown when a positional batch or rest handler is added to options that already have one.
+	class HandlerConflictException : public OptionException {
+	public:
+		HandlerConflictException (char const * handlerName)
+			: OptionException(std::string("Cannot add a second ") + handlerName + ".")
+		{}
+	};
+
+
+	enum class OptionError {
+		None,
+		EmptyOption,        // See EmptyOptionException.
+		OptionConflict,     // See OptionConflictException.
+		AmbiguousOption,    // See AmbiguousOptionException.
+		NegatableSignature, // See NegatableSignatureException.
+		CountedSignature,   // See CountedSignatureException.
+		CollectedKeyword,   // See CollectedKeywordException.
+		HandlerConflict,    // See HandlerConflictException.
+	};
+
+
 	class IteratorException : public Exception {
 	public:
 		IteratorException (std::string const & message)
@@ -381,88 +567,208 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	};
 
 
+	enum class ParseFailure {
+		BadArguments,      // No option matched the arguments.
+		WorkLimitExceeded, // The parse used more steps than ParseLimits::maxSteps allowed.
+		Cancelled,         // ParseLimits::cancel was set while parsing.
+	};
+
+
+	// Caps the work of a parse context. A step is one parser invocation or one advance of an argument iterator.
+	class ParseLimits {
+	public:
+		ParseLimits ()
+			: maxSteps(static_cast<size_t>(-1))
+			, cancel(nullptr)
+		{}
+
+	public:
+		size_t maxSteps;
+		std::atomic<bool> const * cancel; // May be set by another thread. Checked at every step.
+	};
+
+
+	// Returned by an option callback to accept its arguments or to reject one of them without throwing.
+	// A rejection is reported like a RejectArgumentException with the same argument index and message.
+	// Callbacks that return anything else, including bool, always accept. Only a Verdict can reject.
+	template <typename Char>
+	class Verdict {
+	public:
+		typedef std::basic_string<Char> String;
+
+		static Verdict Accept ()
+		{
+			return Verdict(true, 0, String());
+		}
+
+		static Verdict Reject (size_t argIndex = 0, String const & message = String())
+		{
+			return Verdict(false, argIndex, message);
+		}
+
+	private:
+		Verdict (bool accepted, size_t argIndex, String const & message)
+			: accepted(accepted)
+			, argIndex(argIndex)
+			, message(message)
+		{}
+
+	public:
+		bool accepted;
+		size_t argIndex;
+		String message;
+	};
+
+
+	namespace _private
+	{
+		// Converts what a callback returned into a Verdict. Other return types are ignored, as they always have been.
+		template <typename Char, typename R>
+		struct CallbackResult {
+			template <typename F>
+			static Verdict<Char> Call (F const & call)
+			{
+				call();
+				return Verdict<Char>::Accept();
+			}
+		};
+
+		template <typename Char>
+		struct CallbackResult<Char, Verdict<Char>> {
+			template <typename F>
+			static Verdict<Char> Call (F const & call)
+			{
+				return call();
+			}
+		};
+	}
+
+
+	// Holds where and why a parse failed. The message text is only formatted when Message() is called,
+	// so a failure costs no more than a success when only the indices are inspected.
+	// what() gives just the indices, formatted without allocating when the exception is constructed.
 	template <typename Char>
 	class ParseFailedException : public Exception {
 	public:
 		typedef std::basic_string<Char> String;
+		typedef std::shared_ptr<std::vector<String> const> SharedArgs;
 
 		ParseFailedException ()
 			: Exception("")
-		{}
+			, beginIndex(0)
+			, endIndex(0)
+			, failure(ParseFailure::BadArguments)
+		{
+			FormatWhat();
+		}
 
-		ParseFailedException (size_t beginIndex, size_t endIndex, std::vector<String> const & args)
-			: Exception(BaseMessage(beginIndex, endIndex))
+		ParseFailedException (size_t beginIndex, size_t endIndex, SharedArgs const & args)
+			: Exception("")
 			, beginIndex(beginIndex)
 			, endIndex(endIndex)
+			, failure(ParseFailure::BadArguments)
+			, args(args)
 		{
-			BuildMessage(args);
+			FormatWhat();
 		}
 
-		ParseFailedException(size_t beginIndex, size_t endIndex, std::vector<String> const & args, String const & extraReason)
-			: Exception(BaseMessage(beginIndex, endIndex))
+		ParseFailedException (size_t beginIndex, size_t endIndex, ParseFailure failure)
+			: Exception("")
 			, beginIndex(beginIndex)
 			, endIndex(endIndex)
+			, failure(failure)
 		{
-			BuildMessage(args);
-			if (!extraReason.empty()) {
-				MessageAppend(" - ");
-				message += extraReason;
-			}
+			FormatWhat();
 		}
 
-	private:
-		static std::string BaseMessage (size_t beginIndex, size_t endIndex)
+		ParseFailedException (size_t beginIndex, size_t endIndex, SharedArgs const & args, String const & extraReason)
+			: Exception("")
+			, beginIndex(beginIndex)
+			, endIndex(endIndex)
+			, failure(ParseFailure::BadArguments)
+			, args(args)
+			, extraReason(extraReason)
 		{
-			char buffer[128];
-			std::sprintf(buffer, "Parse failed in argument range [%u, %u).",
-				static_cast<unsigned int>(beginIndex),
-				static_cast<unsigned int>(endIndex));
-			return buffer;
+			FormatWhat();
 		}
 
-		void MessageAppend (char const * cstr)
+		virtual char const * what () const throw() override
 		{
-			while (*cstr) {
-				message.push_back(*cstr);
-				++cstr;
-			}
+			return whatMessage;
 		}
 
-		void BuildMessage(std::vector<String> const & args)
+		String Message () const
 		{
-			char buffer[128];
-			if (endIndex == beginIndex + 1) {
-				std::sprintf(buffer, "%u", static_cast<unsigned int>(beginIndex));
-				MessageAppend("Unknown option at index ");
-				MessageAppend(buffer);
-				MessageAppend(": `");
-				message += args[beginIndex];
-				MessageAppend("'");
+			String message;
+			if (failure != ParseFailure::BadArguments) {
+				Append(message, failure == ParseFailure::Cancelled ? "Parse cancelled at index " : "Parse work limit exceeded at index ");
+				Append(message, std::to_string(beginIndex));
+				Append(message, ".");
+				return message;
+			}
+			if (!args) {
+				return message;
 			}
-			else if (endIndex == args.size() + 1) {
-				std::sprintf(buffer, "%u", static_cast<unsigned int>(endIndex - 1));
-				MessageAppend("Bad input for `");
-				message += args[beginIndex];
-				MessageAppend("' at index ");
-				MessageAppend(buffer);
-				MessageAppend(": End of input.");
+			std::vector<String> const & allArgs = *args;
+			if (endIndex == beginIndex + 1 && extraReason.empty()) {
+				Append(message, "Unknown option at index ");
+				Append(message, std::to_string(beginIndex));
+				Append(message, ": `");
+				message += allArgs[beginIndex];
+				Append(message, "'");
+			}
+			else if (endIndex == allArgs.size() + 1) {
+				Append(message, "Bad input for `");
+				message += allArgs[beginIndex];
+				Append(message, "' at index ");
+				Append(message, std::to_string(endIndex - 1));
+				Append(message, ": End of input.");
 			}
 			else {
-				std::sprintf(buffer, "%u", static_cast<unsigned int>(endIndex - 1));
-				MessageAppend("Bad input for `");
-				message += args[beginIndex];
-				MessageAppend("' at index ");
-				MessageAppend(buffer);
-				MessageAppend(": `");
-				message += args[endIndex - 1];
-				MessageAppend("'");
+				Append(message, "Bad input for `");
+				message += allArgs[beginIndex];
+				Append(message, "' at index ");
+				Append(message, std::to_string(endIndex - 1));
+				Append(message, ": `");
+				message += allArgs[endIndex - 1];
+				Append(message, "'");
+			}
+			if (!extraReason.empty()) {
+				Append(message, " - ");
+				message += extraReason;
 			}
+			for (size_t i = 0; i < suggestions.size(); ++i) {
+				Append(message, i == 0 ? " - Did you mean `" : "', `");
+				message += suggestions[i];
+			}
+			if (!suggestions.empty()) {
+				Append(message, "'?");
+			}
+			return message;
+		}
+
+	private:
+		void FormatWhat ()
+		{
+			std::snprintf(whatMessage, sizeof(whatMessage), "Parse failed in argument range [%llu, %llu).",
+				static_cast<unsigned long long>(beginIndex), static_cast<unsigned long long>(endIndex));
+		}
+
+		static void Append (String & message, std::string const & str)
+		{
+			message.append(str.begin(), str.end());
 		}
 
 	public:
-		String message;
 		size_t beginIndex;
 		size_t endIndex;
+		ParseFailure failure;
+		std::vector<String> suggestions; // keyword names close to an unknown option, see OptionsConfig::suggestionDistance
+
+	private:
+		SharedArgs args;
+		String extraReason;
+		char whatMessage[80];
 	};
 
 
@@ -529,12 +835,12 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 
 		String const & operator* () const
 		{
-			return *iter;
+			return attached != nullptr ? *attached : *iter;
 		}
 
 		String const * operator-> () const
 		{
-			return iter.operator->();
+			return attached != nullptr ? attached : iter.operator->();
 		}
 
 	private:
@@ -542,6 +848,7 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 			: iter(iter)
 			, end(end)
 			, opaqueParseContext(opaqueParseContext)
+			, attached(nullptr)
 		{}
 
 		void EnsureSameBacking (ArgsIter const & other) const
@@ -559,6 +866,7 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 		Iter iter;
 		Iter end;
 		void * opaqueParseContext;
+		String const * attached; // the value attached to the current argument, seen in its place until incremented
 	};
 
 
@@ -614,7 +922,7 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 		}
 
 		template <typename Char, typename T>
-		UniqueOpaque OpaqueParse (ParseState<Char> & parseState)
+		UniqueOpaque OpaqueParse (ParseState<Char> & parseState, void const *)
 		{
 			Maybe<T> maybe;
 			if (Parse<Char, T>(parseState, maybe)) {
@@ -625,10 +933,17 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	}
 
 
+	template <typename Char, typename T>
+	struct RawParser;
+
+
 	template <typename Char = char>
 	class ParseState {
 		friend class _private::ParseContextImpl<Char>;
 
+		template <typename C, typename T>
+		friend struct RawParser;
+
 	public:
 		ParseState (ParseState const & other)
 			: iter(other.iter)
@@ -654,12 +969,104 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	};
 
 
+	size_t const UnboundedTokens = static_cast<size_t>(-1);
+
+
+	// Describes the arguments RawParser<Char, T> consumes. Specializations may also declare any of:
+	//     static size_t const MinTokens;  // Defaults to 0 if AllowsEmptyRange, otherwise 1.
+	//     static size_t const MaxTokens;  // Defaults to UnboundedTokens.
+	//     static bool CanStartWith (std::basic_string<Char> const & token);
+	// CanStartWith must return false only if parsing cannot succeed when token is the current argument.
+	// The parsing engine uses these to skip overloads without running their parsers.
 	template <typename Char, typename T>
 	struct RawParserTraits {
 		static bool const AllowsEmptyRange = false;
 	};
 
 
+	namespace _private
+	{
+		template <typename T>
+		struct AlwaysVoid {
+			typedef void type;
+		};
+
+
+		template <typename Traits, typename = void>
+		struct TraitsMinTokens {
+			static size_t const value = Traits::AllowsEmptyRange ? 0 : 1;
+		};
+
+		template <typename Traits>
+		struct TraitsMinTokens<Traits, typename AlwaysVoid<decltype(Traits::MinTokens)>::type> {
+			static size_t const value = Traits::MinTokens;
+		};
+
+
+		template <typename Traits, typename = void>
+		struct TraitsMaxTokens {
+			static size_t const value = UnboundedTokens;
+		};
+
+		template <typename Traits>
+		struct TraitsMaxTokens<Traits, typename AlwaysVoid<decltype(Traits::MaxTokens)>::type> {
+			static size_t const value = Traits::MaxTokens;
+		};
+
+
+		template <typename Char, typename Traits, typename = void>
+		struct TraitsCanStartWith {
+			static bool CanStartWith (std::basic_string<Char> const &)
+			{
+				return true;
+			}
+		};
+
+		template <typename Char, typename Traits>
+		struct TraitsCanStartWith<Char, Traits, typename AlwaysVoid<decltype(&Traits::CanStartWith)>::type> {
+			static bool CanStartWith (std::basic_string<Char> const & token)
+			{
+				return Traits::CanStartWith(token);
+			}
+		};
+
+
+		template <size_t A, size_t B>
+		struct AddTokenCounts {
+			static size_t const value = (A == UnboundedTokens || B == UnboundedTokens) ? UnboundedTokens : A + B;
+		};
+
+
+		template <size_t N, size_t A>
+		struct MultiplyTokenCount {
+			static size_t const value = (A == UnboundedTokens || (A != 0 && N > UnboundedTokens / A)) ? UnboundedTokens : N * A;
+		};
+
+
+		template <typename Char>
+		inline bool IsDigit (Char c)
+		{
+			return '0' <= c && c <= '9';
+		}
+	}
+
+
+	// RawParserTraits<Char, T> with defaults filled in for the optional members.
+	template <typename Char, typename T>
+	struct TokenTraits {
+		typedef RawParserTraits<Char, T> Traits;
+
+		static bool const AllowsEmptyRange = Traits::AllowsEmptyRange;
+		static size_t const MinTokens = _private::TraitsMinTokens<Traits>::value;
+		static size_t const MaxTokens = _private::TraitsMaxTokens<Traits>::value;
+
+		static bool CanStartWith (std::basic_string<Char> const & token)
+		{
+			return _private::TraitsCanStartWith<Char, Traits>::CanStartWith(token);
+		}
+	};
+
+
 	template <typename Char, typename T>
 	struct RawParser {};
 
@@ -667,10 +1074,49 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	template <typename Char, typename T>
 	inline bool RawParse (ParseState<Char> & parseState, void * rawMemory)
 	{
+		if (!_private::ParseContextImpl<Char>::Step(parseState)) {
+			return false;
+		}
 		return RawParser<Char, T>()(parseState, rawMemory);
 	}
 
 
+	namespace _private
+	{
+		template <typename Char>
+		inline bool SkipTokens (ParseState<Char> & parseState, size_t count, bool (*canStartWith)(std::basic_string<Char> const &))
+		{
+			ArgsIter<Char> const startIter = parseState.iter;
+			for (size_t i = 0; i < count; ++i) {
+				if (parseState.iter == parseState.end || (i == 0 && !canStartWith(*parseState.iter))) {
+					parseState.iter = startIter;
+					return false;
+				}
+				++parseState.iter;
+			}
+			return true;
+		}
+	}
+
+
+	// Advances past the arguments that T would be parsed from, without necessarily constructing a T.
+	// Used by Lazy<T> during option matching. When TokenTraits<Char, T> gives a fixed number of arguments, only
+	// CanStartWith is checked, so a bad argument is found when the value is read. Otherwise T is parsed and
+	// discarded. Specialize this for types whose arguments can be checked more cheaply or more strictly.
+	template <typename Char, typename T>
+	struct RawValidator {
+		bool operator() (ParseState<Char> & parseState)
+		{
+			typedef TokenTraits<Char, T> Traits;
+			if (Traits::MinTokens == Traits::MaxTokens) {
+				return _private::SkipTokens<Char>(parseState, Traits::MinTokens, Traits::CanStartWith);
+			}
+			Maybe<T> mValue;
+			return Parse<Char, T>(parseState, mValue);
+		}
+	};
+
+
 	template <typename Char, typename T>
 	inline bool Parse (ParseState<Char> & parseState, Maybe<T> & out)
 	{
@@ -705,6 +1151,18 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 
 
 #ifndef LAMBDA_OPTIONS_DISABLE_BASIC_RAW_PARSERS
+	template <typename Char>
+	struct RawParserTraits<Char, bool> {
+		static bool const AllowsEmptyRange = false;
+		static size_t const MaxTokens = 1;
+
+		static bool CanStartWith (std::basic_string<Char> const & token)
+		{
+			return !token.empty() && (token[0] == 't' || token[0] == 'f');
+		}
+	};
+
+
 	template <typename Char>
 	struct RawParser<Char, bool> {
 		bool operator() (ParseState<Char> & parseState, void * rawMemory)
@@ -725,6 +1183,18 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	};
 
 
+	template <typename Char>
+	struct RawParserTraits<Char, int> {
+		static bool const AllowsEmptyRange = false;
+		static size_t const MaxTokens = 1;
+
+		static bool CanStartWith (std::basic_string<Char> const & token)
+		{
+			return !token.empty() && (_private::IsDigit(token[0]) || token[0] == '-' || token[0] == '+');
+		}
+	};
+
+
 	template <typename Char>
 	struct RawParser<Char, int> {
 		bool operator() (ParseState<Char> & parseState, void * rawMemory)
@@ -734,6 +1204,18 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	};
 
 
+	template <typename Char>
+	struct RawParserTraits<Char, unsigned int> {
+		static bool const AllowsEmptyRange = false;
+		static size_t const MaxTokens = 1;
+
+		static bool CanStartWith (std::basic_string<Char> const & token)
+		{
+			return !token.empty() && (_private::IsDigit(token[0]) || token[0] == '+');
+		}
+	};
+
+
 	template <typename Char>
 	struct RawParser<Char, unsigned int> {
 		bool operator() (ParseState<Char> & parseState, void * rawMemory)
@@ -746,8 +1228,32 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	};
 
 
-	template <typename Char>
-	struct RawParser<Char, float> {
+	namespace _private
+	{
+		template <typename Char>
+		struct FloatTraits {
+			static bool const AllowsEmptyRange = false;
+			static size_t const MaxTokens = 1;
+
+			// Covers digits, signs, a leading decimal point, and the spellings of infinity and NaN.
+			static bool CanStartWith (std::basic_string<Char> const & token)
+			{
+				if (token.empty()) {
+					return false;
+				}
+				Char const c = token[0];
+				return IsDigit(c) || c == '-' || c == '+' || c == '.' || c == 'i' || c == 'I' || c == 'n' || c == 'N';
+			}
+		};
+	}
+
+
+	template <typename Char>
+	struct RawParserTraits<Char, float> : public _private::FloatTraits<Char> {};
+
+
+	template <typename Char>
+	struct RawParser<Char, float> {
 		bool operator() (ParseState<Char> & parseState, void * rawMemory)
 		{
 			return _private::ScanNumber<Char>(parseState, rawMemory, "%f%c");
@@ -755,6 +1261,10 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	};
 
 
+	template <typename Char>
+	struct RawParserTraits<Char, double> : public _private::FloatTraits<Char> {};
+
+
 	template <typename Char>
 	struct RawParser<Char, double> {
 		bool operator() (ParseState<Char> & parseState, void * rawMemory)
@@ -764,6 +1274,18 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	};
 
 
+	template <typename Char>
+	struct RawParserTraits<Char, Char> {
+		static bool const AllowsEmptyRange = false;
+		static size_t const MaxTokens = 1;
+
+		static bool CanStartWith (std::basic_string<Char> const & token)
+		{
+			return token.size() == 1;
+		}
+	};
+
+
 	template <typename Char>
 	struct RawParser<Char, Char> {
 		bool operator() (ParseState<Char> & parseState, void * rawMemory)
@@ -778,6 +1300,13 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	};
 
 
+	template <typename Char>
+	struct RawParserTraits<Char, std::basic_string<Char>> {
+		static bool const AllowsEmptyRange = false;
+		static size_t const MaxTokens = 1;
+	};
+
+
 	template <typename Char>
 	struct RawParser<Char, std::basic_string<Char>> {
 		bool operator() (ParseState<Char> & parseState, void * rawMemory)
@@ -789,9 +1318,33 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	};
 
 
+	template <typename Char>
+	struct RawValidator<Char, std::basic_string<Char>> {
+		bool operator() (ParseState<Char> & parseState)
+		{
+			++parseState.iter;
+			return true;
+		}
+	};
+
+
+	template <typename Char, typename T, size_t N>
+	struct RawParserTraits<Char, std::array<T, N>> {
+		static bool const AllowsEmptyRange = false;
+		static size_t const MinTokens = N * TokenTraits<Char, T>::MinTokens;
+		static size_t const MaxTokens = _private::MultiplyTokenCount<N, TokenTraits<Char, T>::MaxTokens>::value;
+
+		static bool CanStartWith (std::basic_string<Char> const & token)
+		{
+			return TokenTraits<Char, T>::CanStartWith(token);
+		}
+	};
+
+
 	template <typename Char, typename T>
 	struct RawParserTraits<Char, std::array<T, 0>> {
 		static bool const AllowsEmptyRange = true;
+		static size_t const MaxTokens = 0;
 	};
 
 
@@ -866,1369 +1419,4249 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	};
 
 
-	template <typename Char>
-	struct RawParser<Char, Any> {
-	public:
-		bool operator() (ParseState<Char> & parseState, void * rawMemory)
-		{
-			if (parseState.iter == parseState.end) {
-				return false;
+	namespace _private
+	{
+		template <typename Char, typename Tuple, size_t I = 0, size_t N = std::tuple_size<Tuple>::value>
+		struct TupleElementsParser {
+			typedef typename std::tuple_element<I, Tuple>::type T;
+			typedef TupleElementsParser<Char, Tuple, I + 1, N> Next;
+
+			static bool const AllowsEmptyRange = RawParserTraits<Char, T>::AllowsEmptyRange && Next::AllowsEmptyRange;
+			static size_t const MinTokens = TokenTraits<Char, T>::MinTokens + Next::MinTokens;
+			static size_t const MaxTokens = AddTokenCounts<TokenTraits<Char, T>::MaxTokens, Next::MaxTokens>::value;
+
+			static bool CanStartWith (std::basic_string<Char> const & token)
+			{
+				return TokenTraits<Char, T>::CanStartWith(token);
 			}
-			new (rawMemory) Any();
-			++parseState.iter;
-			return true;
-		}
-	};
-#endif
 
+			static bool Parse (ParseState<Char> & parseState, Tuple & tuple, size_t & constructedCount)
+			{
+				if (!RawParserTraits<Char, T>::AllowsEmptyRange && parseState.iter == parseState.end) {
+					return false;
+				}
+				T & elem = std::get<I>(tuple);
+				if (!RawParse<Char, T>(parseState, &elem)) {
+					return false;
+				}
+				++constructedCount;
+				return Next::Parse(parseState, tuple, constructedCount);
+			}
 
-	template <typename Char>
-	inline void ConsumeRest (ParseState<Char> & parseState)
-	{
-		parseState.iter = parseState.end;
-	}
+			static void Destroy (Tuple & tuple, size_t constructedCount)
+			{
+				if (I < constructedCount) {
+					Next::Destroy(tuple, constructedCount);
+					std::get<I>(tuple).~T();
+				}
+			}
+		};
 
 
-	typedef int Priority;
+		template <typename Char, typename Tuple, size_t N>
+		struct TupleElementsParser<Char, Tuple, N, N> {
+			static bool const AllowsEmptyRange = true;
+			static size_t const MinTokens = 0;
+			static size_t const MaxTokens = 0;
 
+			static bool CanStartWith (std::basic_string<Char> const &)
+			{
+				return true;
+			}
 
-	enum class KeywordStyle {
-		Exact,
-		Gnu,
-		Windows,
+			static bool Parse (ParseState<Char> &, Tuple &, size_t &)
+			{
+				return true;
+			}
 
-		Default = Gnu
-	};
+			static void Destroy (Tuple &, size_t)
+			{}
+		};
 
 
-	enum class MatchFlags : size_t {
-		Empty              = 0,
-		IgnoreAsciiCase    = 1 << 0,
-		RelaxedDashes      = 1 << 1,
-		RelaxedUnderscores = 1 << 2,
-		GnuShortGrouping   = 1 << 3,
+		// Constructs each element of a tuple-like type directly in the destination.
+		// Elements that were constructed before a failure are destroyed in reverse order.
+		template <typename Char, typename Tuple>
+		struct TupleParser {
+		private:
+			typedef TupleElementsParser<Char, Tuple> Elements;
 
-		Default = GnuShortGrouping
-	};
+		public:
+			~TupleParser ()
+			{
+				if (!success) {
+					Elements::Destroy(*pTuple, constructedCount);
+				}
+			}
 
-	inline MatchFlags operator& (MatchFlags a, MatchFlags b)
-	{
-		return static_cast<MatchFlags>(static_cast<size_t>(a) & static_cast<size_t>(b));
-	}
+			bool operator() (ParseState<Char> & parseState, void * rawMemory)
+			{
+				success = false;
+				constructedCount = 0;
+				pTuple = reinterpret_cast<Tuple *>(rawMemory);
+				if (!Elements::Parse(parseState, *pTuple, constructedCount)) {
+					return false;
+				}
+				success = true;
+				return true;
+			}
 
-	inline MatchFlags operator| (MatchFlags a, MatchFlags b)
-	{
-		return static_cast<MatchFlags>(static_cast<size_t>(a) | static_cast<size_t>(b));
+		private:
+			bool success;
+			size_t constructedCount;
+			Tuple * pTuple;
+		};
 	}
 
 
-	class OptionsConfig {
-	public:
-		OptionsConfig ()
-			: keywordStyle(KeywordStyle::Default)
-			, matchFlags(MatchFlags::Default)
-		{}
+	template <typename Char, typename A, typename B>
+	struct RawParserTraits<Char, std::pair<A, B>> {
+	private:
+		typedef _private::TupleElementsParser<Char, std::pair<A, B>> Elements;
 
 	public:
-		KeywordStyle keywordStyle;
-		MatchFlags matchFlags;
+		static bool const AllowsEmptyRange = Elements::AllowsEmptyRange;
+		static size_t const MinTokens = Elements::MinTokens;
+		static size_t const MaxTokens = Elements::MaxTokens;
+
+		static bool CanStartWith (std::basic_string<Char> const & token)
+		{
+			return Elements::CanStartWith(token);
+		}
 	};
 
 
-	template <typename Char>
-	class FormattingConfig {
-		typedef std::basic_string<Char> String;
-	public:
-		FormattingConfig ();
-	public:
-		size_t maxWidth;
-		std::vector<String> helpGroupFilter;
-	};
+	template <typename Char, typename A, typename B>
+	struct RawParser<Char, std::pair<A, B>> : public _private::TupleParser<Char, std::pair<A, B>> {};
 
 
-	template <typename Char>
-	class Keyword {
-		typedef std::basic_string<Char> String;
-		static String const nil;
+#if LAMBDA_OPTIONS_VARIADIC_TEMPLATES
+	template <typename Char, typename... Ts>
+	struct RawParserTraits<Char, std::tuple<Ts...>> {
+	private:
+		typedef _private::TupleElementsParser<Char, std::tuple<Ts...>> Elements;
 
 	public:
-		explicit Keyword (
-			String const & name1 = nil,
-			String const & name2 = nil,
-			String const & name3 = nil,
-			String const & name4 = nil)
-		{
-			String const * pNames[] = { &name1, &name2, &name3, &name4 };
-			for (String const * pName : pNames) {
-				if (pName == &nil) {
-					break;
-				}
-				names.emplace_back(*pName);
-			}
-		}
-
-		Keyword & Name (String const & name)
-		{
-			names.emplace_back(name);
-			return *this;
-		}
+		static bool const AllowsEmptyRange = Elements::AllowsEmptyRange;
+		static size_t const MinTokens = Elements::MinTokens;
+		static size_t const MaxTokens = Elements::MaxTokens;
 
-		Keyword & ExactName (String const & exactName)
+		static bool CanStartWith (std::basic_string<Char> const & token)
 		{
-			exactNames.emplace_back(exactName);
-			return *this;
+			return Elements::CanStartWith(token);
 		}
+	};
 
-		Keyword & Text (String const & text)
-		{
-			this->text = text;
-			return *this;
-		}
 
-		Keyword & ArgText (String const & argText)
-		{
-			this->argText = argText;
-			return *this;
-		}
+	template <typename Char, typename... Ts>
+	struct RawParser<Char, std::tuple<Ts...>> : public _private::TupleParser<Char, std::tuple<Ts...>> {};
+#endif
 
-		Keyword & HelpGroup (String const & helpGroup)
-		{
-			this->helpGroup = helpGroup;
-			return *this;
-		}
 
-	public:
-		std::vector<String> names;
-		std::vector<String> exactNames;
-		String text;
-		String argText;
-		String helpGroup;
+#if LAMBDA_OPTIONS_CPP17
+	template <typename Char, typename T>
+	struct RawParserTraits<Char, std::optional<T>> {
+		static bool const AllowsEmptyRange = true;
+		static size_t const MaxTokens = TokenTraits<Char, T>::MaxTokens;
 	};
 
 
-	template <typename Char>
-	typename Keyword<Char>::String const Keyword<Char>::nil;
+	template <typename Char, typename T>
+	struct RawParser<Char, std::optional<T>> {
+		bool operator() (ParseState<Char> & parseState, void * rawMemory)
+		{
+			Maybe<T> mValue;
+			if (Parse<Char, T>(parseState, mValue)) {
+				new (rawMemory) std::optional<T>(std::move(*mValue));
+			}
+			else {
+				new (rawMemory) std::optional<T>();
+			}
+			return true;
+		}
+	};
 
 
 	namespace _private
 	{
-		inline bool FitsAscii (wchar_t c)
-		{
-			return 0 <= c && c < 0x80;
-		}
+		template <typename Char, typename Variant, size_t I = 0, size_t N = std::variant_size<Variant>::value>
+		struct VariantAlternativesParser {
+			typedef std::variant_alternative_t<I, Variant> T;
+			typedef VariantAlternativesParser<Char, Variant, I + 1, N> Next;
 
-		inline bool EqualsCI (char a, char b)
-		{
-			return std::tolower(a) == std::tolower(b);
-		}
+			static bool const AllowsEmptyRange = RawParserTraits<Char, T>::AllowsEmptyRange || Next::AllowsEmptyRange;
+			static size_t const MinTokens = TokenTraits<Char, T>::MinTokens < Next::MinTokens ? TokenTraits<Char, T>::MinTokens : Next::MinTokens;
+			static size_t const MaxTokens = TokenTraits<Char, T>::MaxTokens > Next::MaxTokens ? TokenTraits<Char, T>::MaxTokens : Next::MaxTokens;
 
-		inline bool EqualsCI (wchar_t a, wchar_t b)
-		{
-			if (FitsAscii(a) && FitsAscii(b)) {
-				return std::towlower(a) == std::towlower(b);
+			static bool CanStartWith (std::basic_string<Char> const & token)
+			{
+				return TokenTraits<Char, T>::CanStartWith(token) || Next::CanStartWith(token);
 			}
-			return a == b;
-		}
 
-		template <typename String>
-		bool EqualsCI (String const & a, String const & b)
-		{
-			size_t const N = a.size();
-			if (N != b.size()) {
-				return false;
-			}
-			for (size_t i = 0; i < N; ++i) {
-				if (!EqualsCI(a[i], b[i])) {
-					return false;
+			static bool Parse (ParseState<Char> & parseState, void * rawMemory)
+			{
+				Maybe<T> mValue;
+				if (LAMBDA_OPTIONS_NAMESPACE::Parse<Char, T>(parseState, mValue)) {
+					new (rawMemory) Variant(std::in_place_index<I>, std::move(*mValue));
+					return true;
 				}
+				return Next::Parse(parseState, rawMemory);
 			}
-			return true;
-		}
+		};
 
-		template <typename StringIter, typename Char>
-		size_t SkipAll (StringIter & it, StringIter const & end, Char c)
-		{
-			size_t n = 0;
-			while (it != end && *it == c) {
-				++it;
-				++n;
-			}
-			return n;
-		}
 
-		template <typename Char>
-		bool MatchesName (MatchFlags flags, std::basic_string<Char> const & arg, std::basic_string<Char> const & name)
-		{
-			if (arg == name) {
-				return true;
-			}
+		template <typename Char, typename Variant, size_t N>
+		struct VariantAlternativesParser<Char, Variant, N, N> {
+			static bool const AllowsEmptyRange = false;
+			static size_t const MinTokens = UnboundedTokens;
+			static size_t const MaxTokens = 0;
 
-			if (flags == MatchFlags::Empty) {
+			static bool CanStartWith (std::basic_string<Char> const &)
+			{
 				return false;
 			}
-			if (flags == MatchFlags::IgnoreAsciiCase) {
-				return EqualsCI(arg, name);
-			}
 
-			auto testFlags = [flags] (MatchFlags other) {
-				return (flags & other) == other;
-			};
+			static bool Parse (ParseState<Char> &, void *)
+			{
+				return false;
+			}
+		};
+	}
 
-			bool const ignoreCase = testFlags(MatchFlags::IgnoreAsciiCase);
-			bool const relaxedDashes = testFlags(MatchFlags::RelaxedDashes);
-			bool const relaxedUnderscores = testFlags(MatchFlags::RelaxedUnderscores);
 
-			Char const dash = '-';
-			Char const underscore = '_';
+	template <typename Char, typename... Ts>
+	struct RawParserTraits<Char, std::variant<Ts...>> {
+	private:
+		typedef _private::VariantAlternativesParser<Char, std::variant<Ts...>> Elements;
 
-			auto argIter = arg.begin();
-			auto nameIter = name.begin();
+	public:
+		static bool const AllowsEmptyRange = Elements::AllowsEmptyRange;
+		static size_t const MinTokens = Elements::MinTokens;
+		static size_t const MaxTokens = Elements::MaxTokens;
 
-			auto const argEnd = arg.end();
-			auto const nameEnd = name.end();
+		static bool CanStartWith (std::basic_string<Char> const & token)
+		{
+			return Elements::CanStartWith(token);
+		}
+	};
 
-			{
-				size_t const argDashes = SkipAll(argIter, argEnd, dash);
-				size_t const nameDashes = SkipAll(nameIter, nameEnd, dash);
-				if (argDashes != nameDashes) {
-					return false;
-				}
-			}
 
-			while (true) {
-				while (true) {
-					size_t skipCount = 0;
-					if (relaxedDashes) {
-						skipCount += SkipAll(argIter, argEnd, dash);
-						skipCount += SkipAll(nameIter, nameEnd, dash);
-					}
-					if (relaxedUnderscores) {
-						skipCount += SkipAll(argIter, argEnd, underscore);
-						skipCount += SkipAll(nameIter, nameEnd, underscore);
-					}
-					if (skipCount == 0) {
-						break;
-					}
-				}
-				if (argIter == argEnd || nameIter == nameEnd) {
-					return argIter == argEnd && nameIter == nameEnd;
-				}
-				if (ignoreCase) {
-					if (!EqualsCI(*argIter, *nameIter)) {
-						return false;
-					}
-				}
-				else {
-					if (*argIter != *nameIter) {
-						return false;
-					}
-				}
-				++argIter;
-				++nameIter;
-			}
+	// Alternatives are tried in declaration order. The first one that parses is selected.
+	template <typename Char, typename... Ts>
+	struct RawParser<Char, std::variant<Ts...>> {
+		bool operator() (ParseState<Char> & parseState, void * rawMemory)
+		{
+			return _private::VariantAlternativesParser<Char, std::variant<Ts...>>::Parse(parseState, rawMemory);
 		}
+	};
+#endif
 
-		template <typename Char>
-		class OptionsImpl;
 
-		template <typename Char>
-		class ParseContextImpl;
-	}
+	template <typename Char>
+	struct RawParserTraits<Char, Any> {
+		static bool const AllowsEmptyRange = false;
+		static size_t const MaxTokens = 1;
+	};
 
-	
-	template <typename Char = char>
-	class ParseContext {
-		friend class Options<Char>;
-	
-		typedef std::basic_string<Char> String;
-		typedef _private::OptionsImpl<Char> OptionsImpl;
-		typedef _private::ParseContextImpl<Char> ParseContextImpl;
-	
+
+	template <typename Char>
+	struct RawParser<Char, Any> {
 	public:
-		ParseContext (ParseContext && other);
-		ParseContext & operator= (ParseContext && other);
-	
-#ifdef LAMBDA_OPTIONS_NO_THROW
-		bool Run (ParseFailedException<Char> & e)
-		{
-			return impl->Run(e);
-		}
-#else
-		void Run()
+		bool operator() (ParseState<Char> & parseState, void * rawMemory)
 		{
-			ParseFailedException<Char> e;
-			if (!impl->Run(e)) {
-				throw e;
+			if (parseState.iter == parseState.end) {
+				return false;
 			}
+			new (rawMemory) Any();
+			++parseState.iter;
+			return true;
 		}
+	};
 #endif
-	
-		std::vector<String> const & Args () const
+
+
+#if LAMBDA_OPTIONS_VARIADIC_TEMPLATES
+	template <typename Class, typename T, T Class::* Member>
+	struct AggregateMember {
+		typedef T Type;
+
+		static T & Get (Class & object)
 		{
-			return impl->Args();
+			return object.*Member;
 		}
-	
-	private:
-		ParseContext (std::shared_ptr<OptionsImpl const> opts, std::vector<String> && args, void * userData);
-	
-		ParseContext (ParseContext const & other);   // disable
-		void operator= (ParseContext const & other); // disable
-	
-	private:
-		std::unique_ptr<ParseContextImpl> impl;
 	};
 
 
+#	define LAMBDA_OPTIONS_MEMBER(Class, member) \
+		::LAMBDA_OPTIONS_NAMESPACE::AggregateMember<Class, decltype(Class::member), &Class::member>
+
+
 	namespace _private
 	{
-		template <typename Char>
-		inline bool IsShort (std::basic_string<Char> const & name)
-		{
-			if (name.size() <= 1) {
+		template <typename Char, typename Class, typename... Members>
+		struct AggregateMembersParser {};
+
+
+		template <typename Char, typename Class>
+		struct AggregateMembersParser<Char, Class> {
+			static bool const AllowsEmptyRange = true;
+			static size_t const MinTokens = 0;
+			static size_t const MaxTokens = 0;
+
+			static bool CanStartWith (std::basic_string<Char> const &)
+			{
 				return true;
 			}
-			if (name.size() != 2) {
-				return false;
-			}
-			Char const c = name.front();
-			return c == '-' || c == '/';
-		}
 
-
-		class TypeId {
-		public:
-			bool operator== (TypeId const & other) const
+			static bool Parse (ParseState<Char> &, Class &, size_t &)
 			{
-				return id == other.id;
+				return true;
 			}
 
-#ifdef RTTI_ENABLED
-		private:
-			TypeId (std::type_info const & id)
-				: id(id)
+			static void Destroy (Class &, size_t)
 			{}
+		};
 
-			void operator= (TypeId const &); // disable
 
-		public:
-			template <typename T>
-			static TypeId Get ()
+		template <typename Char, typename Class, typename Member, typename... Rest>
+		struct AggregateMembersParser<Char, Class, Member, Rest...> {
+			typedef typename Member::Type T;
+			typedef AggregateMembersParser<Char, Class, Rest...> Next;
+
+			static bool const AllowsEmptyRange = RawParserTraits<Char, T>::AllowsEmptyRange && Next::AllowsEmptyRange;
+			static size_t const MinTokens = TokenTraits<Char, T>::MinTokens + Next::MinTokens;
+			static size_t const MaxTokens = AddTokenCounts<TokenTraits<Char, T>::MaxTokens, Next::MaxTokens>::value;
+
+			static bool CanStartWith (std::basic_string<Char> const & token)
 			{
-				return TypeId(typeid(T));
+				return TokenTraits<Char, T>::CanStartWith(token);
 			}
 
-		private:
-			std::type_info const & id;
-#else
-		private:
-			TypeId (void const * id)
-				: id(id)
-			{}
-
-		public:
-			template <typename T>
-			static TypeId Get ()
+			static bool Parse (ParseState<Char> & parseState, Class & object, size_t & constructedCount)
 			{
-				static char uniqueMemLoc;
-				return TypeId(&uniqueMemLoc);
+				if (!RawParserTraits<Char, T>::AllowsEmptyRange && parseState.iter == parseState.end) {
+					return false;
+				}
+				T & field = Member::Get(object);
+				if (!RawParse<Char, T>(parseState, &field)) {
+					return false;
+				}
+				++constructedCount;
+				return Next::Parse(parseState, object, constructedCount);
 			}
 
-		private:
-			void const * id;
-#endif
+			static void Destroy (Class & object, size_t constructedCount)
+			{
+				if (constructedCount > 0) {
+					Next::Destroy(object, constructedCount - 1);
+					Member::Get(object).~T();
+				}
+			}
 		};
 	}
 
 
-	template <typename Char>
-	class OptInfo {
+	// The RawParserTraits of an aggregate parsed by AggregateParser, combined from those of its members.
+	template <typename Char, typename Class, typename... Members>
+	struct AggregateTraits {
+	private:
+		typedef _private::AggregateMembersParser<Char, Class, Members...> Fields;
+
 	public:
-		typedef std::function<void(_private::OpaqueValues &)> Callback;
+		static bool const AllowsEmptyRange = Fields::AllowsEmptyRange;
+		static size_t const MinTokens = Fields::MinTokens;
+		static size_t const MaxTokens = Fields::MaxTokens;
 
-		OptInfo (Keyword<Char> const & keyword, std::vector<_private::TypeId> && typeKinds, Callback const & callback)
-			: keyword(keyword)
-			, typeKinds(std::move(typeKinds))
-			, callback(callback)
-		{}
+		static bool CanStartWith (std::basic_string<Char> const & token)
+		{
+			return Fields::CanStartWith(token);
+		}
+	};
 
-		OptInfo (OptInfo && other)
-			: keyword(std::move(other.keyword))
-			, typeKinds(std::move(other.typeKinds))
-			, callback(std::move(other.callback))
-		{}
+
+	// Parses an aggregate by constructing each listed member in place from consecutive arguments,
+	// in the same manner as std::array. Every member of Class must be listed, in declaration order.
+	// The matching RawParserTraits can be taken from the parser's Traits without listing the members again.
+	//
+	//     template <typename Char>
+	//     struct RawParser<Char, Point> : public AggregateParser<Char, Point,
+	//         LAMBDA_OPTIONS_MEMBER(Point, x),
+	//         LAMBDA_OPTIONS_MEMBER(Point, y)> {};
+	//
+	//     template <typename Char>
+	//     struct RawParserTraits<Char, Point> : public RawParser<Char, Point>::Traits {};
+	template <typename Char, typename Class, typename... Members>
+	struct AggregateParser {
+	private:
+		typedef _private::AggregateMembersParser<Char, Class, Members...> Fields;
+
+#if LAMBDA_OPTIONS_CPP17
+		static_assert(std::is_aggregate<Class>::value, "AggregateParser requires an aggregate type.");
+#endif
 
 	public:
-		Keyword<Char> keyword;
-		std::vector<_private::TypeId> typeKinds;
-		Callback callback;
-	};
+		typedef AggregateTraits<Char, Class, Members...> Traits;
 
+		~AggregateParser ()
+		{
+			if (!success) {
+				Fields::Destroy(*pObject, constructedCount);
+			}
+		}
 
-	template <typename Func>
-	struct FuncTraits : public FuncTraits<decltype(&Func::operator())> {};
+		bool operator() (ParseState<Char> & parseState, void * rawMemory)
+		{
+			success = false;
+			constructedCount = 0;
+			pObject = reinterpret_cast<Class *>(rawMemory);
+			if (!Fields::Parse(parseState, *pObject, constructedCount)) {
+				return false;
+			}
+			success = true;
+			return true;
+		}
 
-	template <typename R>
-	struct FuncTraits<R()> {
-		enum { arity = 0 };
-		struct Return { typedef R type; };
+	private:
+		bool success;
+		size_t constructedCount;
+		Class * pObject;
 	};
+#endif
 
-	template <typename R, typename A>
-	struct FuncTraits<R(A)> : FuncTraits<R()> {
-		enum { arity = 1 };
-		struct Arg0 { typedef A type; };
-	};
 
-	template <typename R, typename A, typename B>
-	struct FuncTraits<R(A, B)> : FuncTraits<R(A)> {
-		enum { arity = 2 };
-		struct Arg1 { typedef B type; };
-	};
+	namespace _private
+	{
+		// The arguments a Lazy<T> converts, by their indices in the owning parse context.
+		class LazySource {
+		public:
+			void * opaqueParseContext;
+			size_t optionIndex; // the argument naming the option, where a failed conversion is reported
+			size_t first;
+			size_t last;
+			void const * attached;
+			void * userData;
+		};
+	}
 
-	template <typename R, typename A, typename B, typename C>
-	struct FuncTraits<R(A, B, C)> : FuncTraits<R(A, B)> {
-		enum { arity = 3 };
-		struct Arg2 { typedef C type; };
-	};
 
-	template <typename R, typename A, typename B, typename C, typename D>
-	struct FuncTraits<R(A, B, C, D)> : FuncTraits<R(A, B, C)> {
-		enum { arity = 4 };
-		struct Arg3 { typedef D type; };
-	};
+	// An argument whose conversion is deferred until the callback first reads it.
+	// While options are being matched, only RawValidator<Char, T> is run over the arguments.
+	// The converted value is cached inside the Lazy, and must be read before the owning ParseContext is destroyed.
+	// Get and the operators throw a ParseFailedException if the conversion fails, so builds without exceptions
+	// only have TryGet.
+	template <typename T>
+	class Lazy {
+		template <typename Char, typename T2>
+		friend struct RawParser;
 
-	template <typename R, typename A, typename B, typename C, typename D, typename E>
-	struct FuncTraits<R(A, B, C, D, E)> : FuncTraits<R(A, B, C, D)> {
-		enum { arity = 5 };
-		struct Arg4 { typedef E type; };
-	};
+		typedef bool (*Converter)(_private::LazySource const & source, void * rawValue);
+		typedef void (*Thrower)(_private::LazySource const & source);
 
-	template <typename R, typename A, typename B, typename C, typename D, typename E, typename F>
-	struct FuncTraits<R(A, B, C, D, E, F)> : FuncTraits<R(A, B, C, D, E)> {
-		enum { arity = 6 };
-		struct Arg5 { typedef F type; };
-	};
+	public:
+		Lazy (Lazy && other)
+			: converter(other.converter)
+			, thrower(other.thrower)
+			, source(other.source)
+			, converted(false)
+			, failed(other.failed)
+		{
+			if (other.converted) {
+				new (&u.objectView) T(std::move(other.u.objectView));
+				converted = true;
+			}
+		}
 
-	template <typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G>
-	struct FuncTraits<R(A, B, C, D, E, F, G)> : FuncTraits<R(A, B, C, D, E, F)> {
-		enum { arity = 7 };
-		struct Arg6 { typedef G type; };
-	};
+		~Lazy ()
+		{
+			if (converted) {
+				u.objectView.~T();
+			}
+		}
 
-	template <typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H>
-	struct FuncTraits<R(A, B, C, D, E, F, G, H)> : FuncTraits<R(A, B, C, D, E, F, G)> {
-		enum { arity = 8 };
-		struct Arg7 { typedef H type; };
-	};
+		bool IsConverted () const
+		{
+			return converted;
+		}
 
-	template <typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H, typename I>
-	struct FuncTraits<R(A, B, C, D, E, F, G, H, I)> : FuncTraits<R(A, B, C, D, E, F, G, H)> {
-		enum { arity = 9 };
-		struct Arg8 { typedef I type; };
-	};
+		T * TryGet ()
+		{
+			if (!converted && !failed) {
+				converted = converter(source, u.rawView);
+				failed = !converted;
+			}
+			return converted ? &u.objectView : nullptr;
+		}
 
-	template <typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H, typename I, typename J>
-	struct FuncTraits<R(A, B, C, D, E, F, G, H, I, J)> : FuncTraits<R(A, B, C, D, E, F, G, H, I)> {
-		enum { arity = 10 };
-		struct Arg9 { typedef J type; };
-	};
+#ifndef LAMBDA_OPTIONS_NO_THROW
+		T & Get ()
+		{
+			T * p = TryGet();
+			if (p == nullptr) {
+				thrower(source);
+			}
+			return *p;
+		}
 
-	template <typename X, typename R>
-	struct FuncTraits<R(X::*)() const> {
-		enum { arity = 0 };
-		struct Return { typedef R type; };
-	};
+		T & operator* ()
+		{
+			return Get();
+		}
 
-	template <typename X, typename R, typename A>
-	struct FuncTraits<R(X::*)(A) const> : FuncTraits<R(X::*)() const> {
-		enum { arity = 1 };
-		struct Arg0 { typedef A type; };
-	};
+		T * operator-> ()
+		{
+			return &Get();
+		}
+#endif
 
-	template <typename X, typename R, typename A, typename B>
-	struct FuncTraits<R(X::*)(A, B) const> : FuncTraits<R(X::*)(A) const> {
-		enum { arity = 2 };
-		struct Arg1 { typedef B type; };
-	};
+	private:
+		Lazy (Converter converter, Thrower thrower, _private::LazySource const & source)
+			: converter(converter)
+			, thrower(thrower)
+			, source(source)
+			, converted(false)
+			, failed(false)
+		{}
 
-	template <typename X, typename R, typename A, typename B, typename C>
-	struct FuncTraits<R(X::*)(A, B, C) const> : FuncTraits<R(X::*)(A, B) const> {
-		enum { arity = 3 };
-		struct Arg2 { typedef C type; };
-	};
+		Lazy (Lazy const &);            // disable
+		void operator= (Lazy &&);       // disable
+		void operator= (Lazy const &);  // disable
 
-	template <typename X, typename R, typename A, typename B, typename C, typename D>
-	struct FuncTraits<R(X::*)(A, B, C, D) const> : FuncTraits<R(X::*)(A, B, C) const> {
-		enum { arity = 4 };
-		struct Arg3 { typedef D type; };
+	private:
+		Converter converter;
+		Thrower thrower; // throws the ParseFailedException for a failed conversion
+		_private::LazySource source;
+		union U {
+			char rawView[sizeof(T)];
+			T objectView;
+			U () : rawView() {}
+			~U () {}
+		} u;
+		bool converted;
+		bool failed;
 	};
 
-	template <typename X, typename R, typename A, typename B, typename C, typename D, typename E>
-	struct FuncTraits<R(X::*)(A, B, C, D, E) const> : FuncTraits<R(X::*)(A, B, C, D) const> {
-		enum { arity = 5 };
-		struct Arg4 { typedef E type; };
-	};
 
-	template <typename X, typename R, typename A, typename B, typename C, typename D, typename E, typename F>
-	struct FuncTraits<R(X::*)(A, B, C, D, E, F) const> : FuncTraits<R(X::*)(A, B, C, D, E) const> {
-		enum { arity = 6 };
-		struct Arg5 { typedef F type; };
-	};
+	template <typename Char, typename T>
+	struct RawParserTraits<Char, Lazy<T>> : public TokenTraits<Char, T> {};
 
-	template <typename X, typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G>
-	struct FuncTraits<R(X::*)(A, B, C, D, E, F, G) const> : FuncTraits<R(X::*)(A, B, C, D, E, F) const> {
-		enum { arity = 7 };
-		struct Arg6 { typedef G type; };
-	};
 
-	template <typename X, typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H>
-	struct FuncTraits<R(X::*)(A, B, C, D, E, F, G, H) const> : FuncTraits<R(X::*)(A, B, C, D, E, F, G) const> {
-		enum { arity = 8 };
-		struct Arg7 { typedef H type; };
-	};
+	template <typename Char, typename T>
+	struct RawParser<Char, Lazy<T>> {
+		bool operator() (ParseState<Char> & parseState, void * rawMemory)
+		{
+			ArgsIter<Char> const first = parseState.iter;
+			if (!RawValidator<Char, T>()(parseState)) {
+				return false;
+			}
+			_private::LazySource source;
+			source.opaqueParseContext = _private::ParseContextImpl<Char>::Opaque(parseState);
+			source.optionIndex = static_cast<_private::ParseContextImpl<Char> *>(source.opaqueParseContext)->optionIndex;
+			source.first = first.Index();
+			source.last = parseState.iter.Index();
+			source.attached = _private::ParseContextImpl<Char>::PinAttached(first);
+			source.userData = parseState.userData;
+#ifndef LAMBDA_OPTIONS_NO_THROW
+			new (rawMemory) Lazy<T>(Convert, Throw, source);
+#else
+			new (rawMemory) Lazy<T>(Convert, nullptr, source);
+#endif
+			return true;
+		}
 
-	template <typename X, typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H, typename I>
-	struct FuncTraits<R(X::*)(A, B, C, D, E, F, G, H, I) const> : FuncTraits<R(X::*)(A, B, C, D, E, F, G, H) const> {
-		enum { arity = 9 };
-		struct Arg8 { typedef I type; };
-	};
+	private:
+		static bool Convert (_private::LazySource const & source, void * rawValue)
+		{
+			auto & parseContext = *static_cast<_private::ParseContextImpl<Char> *>(source.opaqueParseContext);
+			ArgsIter<Char> iter = parseContext.IterAt(source.first, static_cast<std::basic_string<Char> const *>(source.attached));
+			ParseState<Char> lazyState(iter, parseContext.IterAt(source.last), source.userData);
+			return RawParse<Char, T>(lazyState, rawValue);
+		}
 
-	template <typename X, typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H, typename I, typename J>
-	struct FuncTraits<R(X::*)(A, B, C, D, E, F, G, H, I, J) const> : FuncTraits<R(X::*)(A, B, C, D, E, F, G, H, I) const> {
-		enum { arity = 10 };
-		struct Arg9 { typedef J type; };
+#ifndef LAMBDA_OPTIONS_NO_THROW
+		// Reports the failure at the arguments converted, as a failed parse of the option would have been.
+		static void Throw (_private::LazySource const & source)
+		{
+			auto & parseContext = *static_cast<_private::ParseContextImpl<Char> *>(source.opaqueParseContext);
+			throw ParseFailedException<Char>(source.optionIndex, source.first + 1, parseContext.sharedArgs);
+		}
+#endif
 	};
 
 
+#ifdef LAMBDA_OPTIONS_FILE_MAPPING
 	namespace _private
 	{
-		class TypeId;
-
-
-		template <typename Char>
-		struct OpaqueParser {
-			typedef UniqueOpaque (*Type)(ParseState<Char> &);
-		};
-
-		template <typename Char>
-		struct DynamicParserMap {
-			typedef std::vector<std::pair<TypeId, typename OpaqueParser<Char>::Type>> Type;
-		};
-
-
-		template <typename Char>
-		class OptionsImpl {
+		class MappedFile {
 		public:
-			typedef std::basic_string<Char> String;
-			typedef LAMBDA_OPTIONS_NAMESPACE::Keyword<Char> Keyword;
-
-
-			OptionsImpl (OptionsConfig const & config)
-				: config(config)
+			MappedFile ()
+				: data(nullptr)
+				, size(0)
 			{}
 
+			~MappedFile ()
+			{
+				if (data != nullptr) {
+#if _WIN32
+					::UnmapViewOfFile(data);
+#else
+					::munmap(const_cast<char *>(data), size);
+#endif
+				}
+			}
 
-			String HelpDescription (FormattingConfig<Char> const & config) const;
+#if _WIN32
+			bool Open (std::wstring const & path)
+			{
+				HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				return Map(file);
+			}
 
+			bool Open (std::string const & path)
+			{
+				HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				return Map(file);
+			}
 
-			void SetHelpGroupPriority (String const & helpGroup, Priority priority)
+		private:
+			bool Map (HANDLE file)
 			{
-				Priority * p = _private::Lookup(helpGroupPriorities, helpGroup);
-				if (p == nullptr) {
-					helpGroupPriorities.emplace_back(helpGroup, priority);
+				if (file == INVALID_HANDLE_VALUE) {
+					return false;
 				}
-				else {
-					*p = priority;
+				LARGE_INTEGER fileSize;
+				bool ok = ::GetFileSizeEx(file, &fileSize) != 0;
+				if (ok && fileSize.QuadPart > 0) {
+					HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+					if (mapping != nullptr) {
+						data = static_cast<char const *>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+						size = static_cast<size_t>(fileSize.QuadPart);
+						::CloseHandle(mapping);
+					}
+					ok = data != nullptr;
 				}
+				::CloseHandle(file);
+				return ok;
 			}
-
-
-			template <typename Func, size_t N>
-			struct Adder {};
-
-
-			template <typename Func>
-			struct Adder<Func, 0> {
-				static void Add (OptionsImpl & opts, Keyword const & keyword, Func const & f)
-				{
-					opts.AddImpl(keyword, f);
+#else
+			bool Open (std::wstring const & path)
+			{
+				size_t const narrowSize = std::wcstombs(nullptr, path.c_str(), 0);
+				if (narrowSize == static_cast<size_t>(-1)) {
+					return false;
 				}
-			};
-
+				std::string narrowPath(narrowSize + 1, '\0');
+				std::wcstombs(&narrowPath[0], path.c_str(), narrowPath.size());
+				narrowPath.resize(narrowSize);
+				return Open(narrowPath);
+			}
 
-			template <typename Func>
-			struct Adder<Func, 1> {
-				static void Add (OptionsImpl & opts, Keyword const & keyword, Func const & f)
-				{
-					typedef typename FuncTraits<Func>::Arg0::type A;
-					opts.AddImpl<A>(keyword, f);
+			bool Open (std::string const & path)
+			{
+				int fd = ::open(path.c_str(), O_RDONLY);
+				if (fd < 0) {
+					return false;
 				}
-			};
+				struct stat info;
+				bool ok = ::fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+				if (ok && info.st_size > 0) {
+					void * p = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+					if (p != MAP_FAILED) {
+						data = static_cast<char const *>(p);
+						size = static_cast<size_t>(info.st_size);
+					}
+					ok = data != nullptr;
+				}
+				::close(fd);
+				return ok;
+			}
+#endif
 
+		private:
+			MappedFile (MappedFile const &);        // disable
+			void operator= (MappedFile const &);    // disable
 
-			template <typename Func>
-			struct Adder<Func, 2> {
-				static void Add (OptionsImpl & opts, Keyword const & keyword, Func const & f)
-				{
-					typedef typename FuncTraits<Func>::Arg0::type A;
-					typedef typename FuncTraits<Func>::Arg1::type B;
-					opts.AddImpl<A,B>(keyword, f);
-				}
-			};
+		public:
+			char const * data;
+			size_t size;
+		};
+	}
 
 
-			template <typename Func>
-			struct Adder<Func, 3> {
-				static void Add (OptionsImpl & opts, Keyword const & keyword, Func const & f)
-				{
-					typedef typename FuncTraits<Func>::Arg0::type A;
-					typedef typename FuncTraits<Func>::Arg1::type B;
-					typedef typename FuncTraits<Func>::Arg2::type C;
-					opts.AddImpl<A,B,C>(keyword, f);
-				}
-			};
+	// A read-only view of a memory-mapped file. The argument is the file path, optionally prefixed with '@'.
+	// The mapping is owned by the ParseContext and is released when the ParseContext is destroyed.
+	// Only available when LAMBDA_OPTIONS_FILE_MAPPING is defined, since it pulls in the platform headers.
+	class FileContents {
+	public:
+		FileContents (char const * data, size_t size)
+			: data(data)
+			, size(size)
+		{}
 
+		char const * Data () const
+		{
+			return data;
+		}
 
-			template <typename Func>
-			struct Adder<Func, 4> {
-				static void Add (OptionsImpl & opts, Keyword const & keyword, Func const & f)
-				{
-					typedef typename FuncTraits<Func>::Arg0::type A;
-					typedef typename FuncTraits<Func>::Arg1::type B;
-					typedef typename FuncTraits<Func>::Arg2::type C;
-					typedef typename FuncTraits<Func>::Arg3::type D;
-					opts.AddImpl<A,B,C,D>(keyword, f);
-				}
-			};
+		size_t Size () const
+		{
+			return size;
+		}
 
+		char const * begin () const
+		{
+			return data;
+		}
 
-			template <typename Func>
-			struct Adder<Func, 5> {
-				static void Add (OptionsImpl & opts, Keyword const & keyword, Func const & f)
-				{
-					typedef typename FuncTraits<Func>::Arg0::type A;
-					typedef typename FuncTraits<Func>::Arg1::type B;
-					typedef typename FuncTraits<Func>::Arg2::type C;
-					typedef typename FuncTraits<Func>::Arg3::type D;
-					typedef typename FuncTraits<Func>::Arg4::type E;
-					opts.AddImpl<A,B,C,D,E>(keyword, f);
-				}
-			};
+		char const * end () const
+		{
+			return data + size;
+		}
 
+	private:
+		char const * data;
+		size_t size;
+	};
 
-			template <typename Func>
-			struct Adder<Func, 6> {
-				static void Add(OptionsImpl & opts, Keyword const & keyword, Func const & f)
-				{
-					typedef typename FuncTraits<Func>::Arg0::type A;
-					typedef typename FuncTraits<Func>::Arg1::type B;
-					typedef typename FuncTraits<Func>::Arg2::type C;
-					typedef typename FuncTraits<Func>::Arg3::type D;
-					typedef typename FuncTraits<Func>::Arg4::type E;
-					typedef typename FuncTraits<Func>::Arg5::type F;
-					opts.AddImpl<A, B, C, D, E, F>(keyword, f);
-				}
-			};
 
+	template <typename Char>
+	struct RawParserTraits<Char, FileContents> {
+		static bool const AllowsEmptyRange = false;
+		static size_t const MaxTokens = 1;
 
-			template <typename Func>
-			struct Adder<Func, 7> {
-				static void Add(OptionsImpl & opts, Keyword const & keyword, Func const & f)
-				{
-					typedef typename FuncTraits<Func>::Arg0::type A;
-					typedef typename FuncTraits<Func>::Arg1::type B;
-					typedef typename FuncTraits<Func>::Arg2::type C;
-					typedef typename FuncTraits<Func>::Arg3::type D;
-					typedef typename FuncTraits<Func>::Arg4::type E;
-					typedef typename FuncTraits<Func>::Arg5::type F;
-					typedef typename FuncTraits<Func>::Arg6::type G;
-					opts.AddImpl<A, B, C, D, E, F, G>(keyword, f);
-				}
-			};
-
-
-			template <typename Func>
-			struct Adder<Func, 8> {
-				static void Add(OptionsImpl & opts, Keyword const & keyword, Func const & f)
-				{
-					typedef typename FuncTraits<Func>::Arg0::type A;
-					typedef typename FuncTraits<Func>::Arg1::type B;
-					typedef typename FuncTraits<Func>::Arg2::type C;
-					typedef typename FuncTraits<Func>::Arg3::type D;
-					typedef typename FuncTraits<Func>::Arg4::type E;
-					typedef typename FuncTraits<Func>::Arg5::type F;
-					typedef typename FuncTraits<Func>::Arg6::type G;
-					typedef typename FuncTraits<Func>::Arg7::type H;
-					opts.AddImpl<A, B, C, D, E, F, G, H>(keyword, f);
-				}
-			};
+		static bool CanStartWith (std::basic_string<Char> const & token)
+		{
+			return !token.empty() && !(token.size() == 1 && token[0] == '@');
+		}
+	};
 
 
-			template <typename Func>
-			struct Adder<Func, 9> {
-				static void Add(OptionsImpl & opts, Keyword const & keyword, Func const & f)
-				{
-					typedef typename FuncTraits<Func>::Arg0::type A;
-					typedef typename FuncTraits<Func>::Arg1::type B;
-					typedef typename FuncTraits<Func>::Arg2::type C;
-					typedef typename FuncTraits<Func>::Arg3::type D;
-					typedef typename FuncTraits<Func>::Arg4::type E;
-					typedef typename FuncTraits<Func>::Arg5::type F;
-					typedef typename FuncTraits<Func>::Arg6::type G;
-					typedef typename FuncTraits<Func>::Arg7::type H;
-					typedef typename FuncTraits<Func>::Arg8::type I;
-					opts.AddImpl<A, B, C, D, E, F, G, H, I>(keyword, f);
-				}
-			};
+	template <typename Char>
+	struct RawParser<Char, FileContents> {
+		bool operator() (ParseState<Char> & parseState, void * rawMemory)
+		{
+			std::basic_string<Char> const & arg = *parseState.iter;
+			size_t const offset = (!arg.empty() && arg[0] == '@') ? 1 : 0;
+			if (arg.size() == offset) {
+				return false;
+			}
+			_private::MappedFile const * file = _private::ParseContextImpl<Char>::MapFile(parseState, arg.substr(offset));
+			if (file == nullptr) {
+				return false;
+			}
+			new (rawMemory) FileContents(file->data, file->size);
+			++parseState.iter;
+			return true;
+		}
+	};
+#endif
 
 
-			template <typename Func>
-			struct Adder<Func, 10> {
-				static void Add(OptionsImpl & opts, Keyword const & keyword, Func const & f)
-				{
-					typedef typename FuncTraits<Func>::Arg0::type A;
-					typedef typename FuncTraits<Func>::Arg1::type B;
-					typedef typename FuncTraits<Func>::Arg2::type C;
-					typedef typename FuncTraits<Func>::Arg3::type D;
-					typedef typename FuncTraits<Func>::Arg4::type E;
-					typedef typename FuncTraits<Func>::Arg5::type F;
-					typedef typename FuncTraits<Func>::Arg6::type G;
-					typedef typename FuncTraits<Func>::Arg7::type H;
-					typedef typename FuncTraits<Func>::Arg8::type I;
-					typedef typename FuncTraits<Func>::Arg9::type J;
-					opts.AddImpl<A, B, C, D, E, F, G, H, I, J>(keyword, f);
-				}
-			};
+	// Describes the values an output span option fills. There is no RawParser for Span<T> itself.
+	template <typename Char, typename T>
+	struct RawParserTraits<Char, Span<T>> {
+		static bool const AllowsEmptyRange = true;
+	};
 
 
-			template <typename Func>
-			void AddOption (Keyword const & keyword, Func const & f)
-			{
-				Keyword kw = MassageKeyword(keyword);
-				Adder<Func, FuncTraits<Func>::arity>::Add(*this, kw, f);
-			}
+	namespace _private
+	{
+		// The values parsed for an output span. Each parse context keeps one per span option and reuses it for
+		// every occurrence, so staging only allocates when an occurrence has more values than any before it.
+		template <typename T>
+		class SpanScratch {
+		public:
+			SpanScratch ()
+				: size(0)
+				, direct(false)
+			{}
 
+		public:
+			Span<T> destination;
+			std::vector<T> values; // the staged values, unused when they are written straight to destination
+			size_t size;
+			bool direct;           // set when no other overload can match, so values go straight to destination
+		};
 
-			Keyword MassageKeyword (Keyword const & proto)
-			{
-				Keyword kw(proto);
-				std::vector<String> & names = kw.names;
-				for (String & name : names) {
-					switch (config.keywordStyle) {
-						case KeywordStyle::Exact: {
-							continue;
-						} break;
-						case KeywordStyle::Gnu: {
-							if (name.size() == 1) {
-								name.insert(0, 1, '-');
-							}
-							else if (name.size() == 2 && name[0] == '-') {
-								continue;
-							}
-							else {
-								while (!_private::IsPrefixOf("--", name)) {
-									name.insert(0, 1, '-');
-								}
-							}
-						} break;
-						case KeywordStyle::Windows: {
-							if (name.size() >= 1 && name[0] == '/') {
-								continue;
-							}
-							name.insert(0, 1, '/');
-						} break;
-						default: {
-							Assert(__LINE__, false);
-						}
+		// Parses consecutive T values for the bound destination span, like the std::vector parser.
+		// When the option's keyword has no other overload, the values are written to the destination as they are
+		// parsed. Otherwise the overload may still lose, so they are staged until CommitSpan.
+		// Fails if more values follow than the destination can hold.
+		template <typename Char, typename T>
+		UniqueOpaque ParseIntoSpan (ParseState<Char> & parseState, void const * binding)
+		{
+			SpanScratch<T> & scratch = ParseContextImpl<Char>::template ScratchFor<T>(parseState, binding);
+			scratch.destination = *static_cast<Span<T> const *>(binding);
+			scratch.values.clear();
+			scratch.size = 0;
+			scratch.direct = ParseContextImpl<Char>::SoleOverload(parseState);
+			while (parseState.iter != parseState.end) {
+				if (scratch.size == scratch.destination.Size()) {
+					size_t & iterHighMark = ParseContextImpl<Char>::IterHighMark(parseState);
+					size_t const overflowIndex = iterHighMark;
+					Maybe<T> mOverflow;
+					if (Parse<Char, T>(parseState, mOverflow)) {
+						iterHighMark = overflowIndex;
+						return UniqueOpaque(nullptr, [] (void *) {});
 					}
+					break;
+				}
+				Maybe<T> mValue;
+				if (!Parse<Char, T>(parseState, mValue)) {
+					break;
+				}
+				if (scratch.direct) {
+					scratch.destination.Data()[scratch.size] = std::move(*mValue);
+				}
+				else {
+					scratch.values.push_back(std::move(*mValue));
 				}
+				++scratch.size;
+			}
+			return UniqueOpaque(&scratch, [] (void *) {});
+		}
 
-				std::vector<String> & exactNames = kw.exactNames;
-				names.insert(names.end(), exactNames.begin(), exactNames.end());
-				exactNames.clear();
+		// Moves any staged values into the destination once their overload runs.
+		template <typename T>
+		Span<T> CommitSpan (UniqueOpaque & opaque)
+		{
+			SpanScratch<T> & scratch = *static_cast<SpanScratch<T> *>(opaque.get());
+			if (!scratch.direct) {
+				std::move(scratch.values.begin(), scratch.values.end(), scratch.destination.Data());
+			}
+			return Span<T>(scratch.destination.Data(), scratch.size);
+		}
+	}
 
-				std::sort(names.begin(), names.end());
-				auto it = std::unique(names.begin(), names.end());
-				names.erase(it, names.end());
 
-				return kw;
-			}
+	template <typename Char>
+	inline void ConsumeRest (ParseState<Char> & parseState)
+	{
+		parseState.iter = parseState.end;
+	}
 
 
-			bool Intersecting (Keyword const & kw1, Keyword const & kw2, size_t & i, size_t & j) const
-			{
-				Assert(__LINE__, kw1.exactNames.empty());
-				Assert(__LINE__, kw2.exactNames.empty());
+	typedef int Priority;
 
-				for (i = 0; i < kw1.names.size(); ++i) {
-					String const & name = kw1.names[i];
-					for (j = 0; j < kw2.names.size(); ++j) {
-						String const & otherName = kw2.names[j];
-						if (MatchesName(config.matchFlags, name, otherName)) {
-							return true;
-						}
-					}
-				}
-				return false;
-			}
 
+	enum class KeywordStyle {
+		Exact,
+		Gnu,
+		Windows,
 
-			void NewInfo (Keyword const & keyword, std::vector<TypeId> & typeKinds, typename OptInfo<Char>::Callback const & func, size_t arity)
-			{
-				if (infosByArity.size() <= arity) {
-					infosByArity.resize(arity + 1);
-				}
-				auto & infos = infosByArity[arity];
-#ifndef LAMBDA_OPTIONS_NO_THROW
-				for (auto & info : infos) {
-					size_t i;
-					size_t j;
-					if (Intersecting(keyword, info.keyword, i, j) && info.typeKinds == typeKinds) {
-						throw OptionConflictException<Char>(keyword.names[i], info.keyword.names[j], arity);
-					}
-				}
-#endif
-				infos.emplace_back(keyword, std::move(typeKinds), func);
-			}
+		Default = Gnu
+	};
 
-			void AddImpl (Keyword const & keyword, std::function<void()> const & func)
-			{
-#ifndef LAMBDA_OPTIONS_NO_THROW
-				if (keyword.names.empty()) {
-					throw EmptyOptionException();
-				}
-#endif
-				auto wrapper = [=] (OpaqueValues &) {
-					func();
-				};
-				std::vector<TypeId> typeKinds;
-				NewInfo(keyword, typeKinds, wrapper, 0);
-			}
 
-			template <typename A>
-			void AddImpl (Keyword const & keyword, std::function<void(A)> const & func)
-			{
-				typedef typename SimplifyType<A>::type A2;
-				auto wrapper = [=] (OpaqueValues & vals) {
-					A2 && a = ReifyOpaque<A2>(vals[0]);
-					func(std::forward<A>(a));
-				};
-				std::vector<TypeId> typeKinds;
-				PushTypeId<A2>(typeKinds);
-				NewInfo(keyword, typeKinds, wrapper, 1);
-			}
+	enum class MatchFlags : size_t {
+		Empty              = 0,
+		IgnoreAsciiCase    = 1 << 0,
+		RelaxedDashes      = 1 << 1,
+		RelaxedUnderscores = 1 << 2,
+		GnuShortGrouping   = 1 << 3,
 
-			template <typename A, typename B>
-			void AddImpl (Keyword const & keyword, std::function<void(A,B)> const & func)
-			{
-				typedef typename SimplifyType<A>::type A2;
-				typedef typename SimplifyType<B>::type B2;
-				auto wrapper = [=] (OpaqueValues & vals) {
-					A2 && a = ReifyOpaque<A2>(vals[0]);
-					B2 && b = ReifyOpaque<B2>(vals[1]);
-					func(std::forward<A>(a), std::forward<B>(b));
-				};
-				std::vector<TypeId> typeKinds;
-				PushTypeId<A2>(typeKinds);
-				PushTypeId<B2>(typeKinds);
-				NewInfo(keyword, typeKinds, wrapper, 2);
-			}
+		Default = GnuShortGrouping
+	};
 
-			template <typename A, typename B, typename C>
-			void AddImpl (Keyword const & keyword, std::function<void(A,B,C)> const & func)
-			{
-				typedef typename SimplifyType<A>::type A2;
-				typedef typename SimplifyType<B>::type B2;
-				typedef typename SimplifyType<C>::type C2;
-				auto wrapper = [=] (OpaqueValues & vals) {
-					A2 && a = ReifyOpaque<A2>(vals[0]);
-					B2 && b = ReifyOpaque<B2>(vals[1]);
-					C2 && c = ReifyOpaque<C2>(vals[2]);
-					func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c));
-				};
-				std::vector<TypeId> typeKinds;
-				PushTypeId<A2>(typeKinds);
-				PushTypeId<B2>(typeKinds);
-				PushTypeId<C2>(typeKinds);
-				NewInfo(keyword, typeKinds, wrapper, 3);
-			}
+	inline MatchFlags operator& (MatchFlags a, MatchFlags b)
+	{
+		return static_cast<MatchFlags>(static_cast<size_t>(a) & static_cast<size_t>(b));
+	}
 
-			template <typename A, typename B, typename C, typename D>
-			void AddImpl (Keyword const & keyword, std::function<void(A,B,C,D)> const & func)
-			{
-				typedef typename SimplifyType<A>::type A2;
-				typedef typename SimplifyType<B>::type B2;
-				typedef typename SimplifyType<C>::type C2;
-				typedef typename SimplifyType<D>::type D2;
-				auto wrapper = [=] (OpaqueValues & vals) {
-					A2 && a = ReifyOpaque<A2>(vals[0]);
-					B2 && b = ReifyOpaque<B2>(vals[1]);
-					C2 && c = ReifyOpaque<C2>(vals[2]);
-					D2 && d = ReifyOpaque<D2>(vals[3]);
-					func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d));
-				};
-				std::vector<TypeId> typeKinds;
-				PushTypeId<A2>(typeKinds);
-				PushTypeId<B2>(typeKinds);
-				PushTypeId<C2>(typeKinds);
-				PushTypeId<D2>(typeKinds);
-				NewInfo(keyword, typeKinds, wrapper, 4);
-			}
+	inline MatchFlags operator| (MatchFlags a, MatchFlags b)
+	{
+		return static_cast<MatchFlags>(static_cast<size_t>(a) | static_cast<size_t>(b));
+	}
 
-			template <typename A, typename B, typename C, typename D, typename E>
-			void AddImpl (Keyword const & keyword, std::function<void(A,B,C,D,E)> const & func)
-			{
-				typedef typename SimplifyType<A>::type A2;
-				typedef typename SimplifyType<B>::type B2;
-				typedef typename SimplifyType<C>::type C2;
+
+	class OptionsConfig {
+	public:
+		OptionsConfig ()
+			: keywordStyle(KeywordStyle::Default)
+			, matchFlags(MatchFlags::Default)
+			, deterministic(false)
+			, adaptiveOrdering(false)
+			, suggestionDistance(0)
+			, maxSuggestions(3)
+			, endOfOptions(false)
+		{}
+
+	public:
+		KeywordStyle keywordStyle;
+		MatchFlags matchFlags;
+
+		// Each keyword may have one overload and there may be one keyword-less option. Every token is then
+		// resolved by looking at it alone, so parsing never backtracks and runs in time linear in the arguments.
+		// No prefix may begin another prefix or a name, so a token starting with a prefix is always that option's.
+		bool deterministic;
+
+		// Each parse context moves a keyword to the front of its lookup order once it matches. Only the lookup
+		// order changes; keywords that share a name with another keyword are always resolved together.
+		bool adaptiveOrdering;
+
+		// An unknown option lists up to maxSuggestions of the keyword names nearest to it in its ParseFailedException,
+		// counting single-character insertions, deletions, substitutions and adjacent swaps. Names more than
+		// suggestionDistance edits away are never suggested. Zero disables suggestions.
+		size_t suggestionDistance;
+		size_t maxSuggestions;
+
+		// An argument "--" ends the options, as in POSIX. The arguments after it are never matched against keywords.
+		// They go to the rest handler at once if there is one, otherwise to the positional batch at once, otherwise to
+		// the keyword-less option one at a time.
+		bool endOfOptions;
+	};
+
+
+	template <typename Char>
+	class FormattingConfig {
+		typedef std::basic_string<Char> String;
+	public:
+		FormattingConfig ();
+	public:
+		size_t maxWidth;
+		std::vector<String> helpGroupFilter;
+	};
+
+
+	template <typename Char>
+	class Keyword {
+		typedef std::basic_string<Char> String;
+		static String const nil;
+
+	public:
+		explicit Keyword (
+			String const & name1 = nil,
+			String const & name2 = nil,
+			String const & name3 = nil,
+			String const & name4 = nil)
+			: negatable(false)
+			, counted(false)
+		{
+			String const * pNames[] = { &name1, &name2, &name3, &name4 };
+			for (String const * pName : pNames) {
+				if (pName == &nil) {
+					break;
+				}
+				names.emplace_back(*pName);
+			}
+		}
+
+		Keyword & Name (String const & name)
+		{
+			names.emplace_back(name);
+			return *this;
+		}
+
+		Keyword & ExactName (String const & exactName)
+		{
+			exactNames.emplace_back(exactName);
+			return *this;
+		}
+
+		// Matches any argument beginning with prefix, such as -I/usr/include for the prefix -I, and parses the rest
+		// of the argument as the first value. An argument that is just the prefix takes its values from the arguments
+		// after it. Prefixes are matched exactly, regardless of the keyword style and match flags.
+		Keyword & Prefix (String const & prefix)
+		{
+			prefixes.emplace_back(prefix);
+			return *this;
+		}
+
+		// Also matches each long name with "no-" after its leading dashes or slash, such as --no-color for --color.
+		// The option's function takes a single bool, which is false when a negated name was given.
+		Keyword & Negatable ()
+		{
+			negatable = true;
+			return *this;
+		}
+
+		// Counts the occurrences of the option, such as -v -v or -vv, instead of running its function for each one.
+		// The function takes a single integer and runs once at the end of a parse, if the option was given.
+		// If it rejects, the parse fails at the option's first occurrence.
+		Keyword & Counted ()
+		{
+			counted = true;
+			return *this;
+		}
+
+		Keyword & Text (String const & text)
+		{
+			this->text = text;
+			return *this;
+		}
+
+		Keyword & ArgText (String const & argText)
+		{
+			this->argText = argText;
+			return *this;
+		}
+
+		Keyword & HelpGroup (String const & helpGroup)
+		{
+			this->helpGroup = helpGroup;
+			return *this;
+		}
+
+	public:
+		std::vector<String> names;
+		std::vector<String> exactNames;
+		std::vector<String> prefixes;
+		std::vector<String> negatedNames; // filled in from names when a negatable option is added
+		bool negatable;
+		bool counted;
+		String text;
+		String argText;
+		String helpGroup;
+	};
+
+
+	template <typename Char>
+	typename Keyword<Char>::String const Keyword<Char>::nil;
+
+
+	namespace _private
+	{
+		inline bool FitsAscii (wchar_t c)
+		{
+			return 0 <= c && c < 0x80;
+		}
+
+		inline bool EqualsCI (char a, char b)
+		{
+			return std::tolower(a) == std::tolower(b);
+		}
+
+		inline bool EqualsCI (wchar_t a, wchar_t b)
+		{
+			if (FitsAscii(a) && FitsAscii(b)) {
+				return std::towlower(a) == std::towlower(b);
+			}
+			return a == b;
+		}
+
+		template <typename String>
+		bool EqualsCI (String const & a, String const & b)
+		{
+			size_t const N = a.size();
+			if (N != b.size()) {
+				return false;
+			}
+			for (size_t i = 0; i < N; ++i) {
+				if (!EqualsCI(a[i], b[i])) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		template <typename StringIter, typename Char>
+		size_t SkipAll (StringIter & it, StringIter const & end, Char c)
+		{
+			size_t n = 0;
+			while (it != end && *it == c) {
+				++it;
+				++n;
+			}
+			return n;
+		}
+
+		// Compares the argument characters in [argBegin, argEnd) against name, so part of an argument can be matched in place.
+		template <typename Char, typename ArgIter>
+		bool MatchesName (MatchFlags flags, ArgIter argBegin, ArgIter argEnd, std::basic_string<Char> const & name)
+		{
+			bool const sameSize = static_cast<size_t>(argEnd - argBegin) == name.size();
+			if (sameSize && std::equal(argBegin, argEnd, name.begin())) {
+				return true;
+			}
+
+			if (flags == MatchFlags::Empty) {
+				return false;
+			}
+			if (flags == MatchFlags::IgnoreAsciiCase) {
+				return sameSize && std::equal(argBegin, argEnd, name.begin(), [] (Char a, Char b) {
+					return EqualsCI(a, b);
+				});
+			}
+
+			auto testFlags = [flags] (MatchFlags other) {
+				return (flags & other) == other;
+			};
+
+			bool const ignoreCase = testFlags(MatchFlags::IgnoreAsciiCase);
+			bool const relaxedDashes = testFlags(MatchFlags::RelaxedDashes);
+			bool const relaxedUnderscores = testFlags(MatchFlags::RelaxedUnderscores);
+
+			Char const dash = '-';
+			Char const underscore = '_';
+
+			auto argIter = argBegin;
+			auto nameIter = name.begin();
+
+			auto const nameEnd = name.end();
+
+			{
+				size_t const argDashes = SkipAll(argIter, argEnd, dash);
+				size_t const nameDashes = SkipAll(nameIter, nameEnd, dash);
+				if (argDashes != nameDashes) {
+					return false;
+				}
+			}
+
+			while (true) {
+				while (true) {
+					size_t skipCount = 0;
+					if (relaxedDashes) {
+						skipCount += SkipAll(argIter, argEnd, dash);
+						skipCount += SkipAll(nameIter, nameEnd, dash);
+					}
+					if (relaxedUnderscores) {
+						skipCount += SkipAll(argIter, argEnd, underscore);
+						skipCount += SkipAll(nameIter, nameEnd, underscore);
+					}
+					if (skipCount == 0) {
+						break;
+					}
+				}
+				if (argIter == argEnd || nameIter == nameEnd) {
+					return argIter == argEnd && nameIter == nameEnd;
+				}
+				if (ignoreCase) {
+					if (!EqualsCI(*argIter, *nameIter)) {
+						return false;
+					}
+				}
+				else {
+					if (*argIter != *nameIter) {
+						return false;
+					}
+				}
+				++argIter;
+				++nameIter;
+			}
+		}
+
+		template <typename Char>
+		bool MatchesName (MatchFlags flags, std::basic_string<Char> const & arg, std::basic_string<Char> const & name)
+		{
+			return MatchesName(flags, arg.begin(), arg.end(), name);
+		}
+
+		template <typename Char>
+		class OptionsImpl;
+
+		template <typename Char>
+		class ParseContextImpl;
+	}
+
+	
+	template <typename Char = char>
+	class ParseContext {
+		friend class Options<Char>;
+	
+		typedef std::basic_string<Char> String;
+		typedef _private::OptionsImpl<Char> OptionsImpl;
+		typedef _private::ParseContextImpl<Char> ParseContextImpl;
+	
+	public:
+		ParseContext (ParseContext && other);
+		ParseContext & operator= (ParseContext && other);
+	
+		// Reports a failed parse through e and the return value instead of throwing.
+		bool Run (ParseFailedException<Char> & e)
+		{
+			return impl->Run(e);
+		}
+
+		// Appends every failure to errors in one pass. After a failure, parsing resumes at the next argument
+		// that names a keyword, and no further callbacks are run. Returns true if nothing failed.
+		bool Run (std::vector<ParseFailedException<Char>> & errors)
+		{
+			return impl->Run(errors);
+		}
+
+#ifndef LAMBDA_OPTIONS_NO_THROW
+		void Run()
+		{
+			ParseFailedException<Char> e;
+			if (!impl->Run(e)) {
+				throw e;
+			}
+		}
+#endif
+	
+		std::vector<String> const & Args () const
+		{
+			return impl->Args();
+		}
+
+		// Once a limit is reached, parsers are no longer invoked and Run fails with a ParseFailure other than BadArguments.
+		void SetLimits (ParseLimits const & limits)
+		{
+			impl->limits = limits;
+		}
+	
+	private:
+		ParseContext (std::shared_ptr<OptionsImpl const> opts, std::vector<String> && args, void * userData);
+	
+		ParseContext (ParseContext const & other);   // disable
+		void operator= (ParseContext const & other); // disable
+	
+	private:
+		std::unique_ptr<ParseContextImpl> impl;
+	};
+
+
+	namespace _private
+	{
+		template <typename Char>
+		inline bool IsShort (std::basic_string<Char> const & name)
+		{
+			if (name.size() <= 1) {
+				return true;
+			}
+			if (name.size() != 2) {
+				return false;
+			}
+			Char const c = name.front();
+			return c == '-' || c == '/';
+		}
+
+
+		class TypeId {
+		public:
+			bool operator== (TypeId const & other) const
+			{
+				return id == other.id;
+			}
+
+#ifdef RTTI_ENABLED
+		private:
+			TypeId (std::type_info const & id)
+				: id(id)
+			{}
+
+			void operator= (TypeId const &); // disable
+
+		public:
+			TypeId (TypeId const &) = default;
+
+			template <typename T>
+			static TypeId Get ()
+			{
+				return TypeId(typeid(T));
+			}
+
+		private:
+			std::type_info const & id;
+#else
+		private:
+			TypeId (void const * id)
+				: id(id)
+			{}
+
+		public:
+			template <typename T>
+			static TypeId Get ()
+			{
+				static char uniqueMemLoc;
+				return TypeId(&uniqueMemLoc);
+			}
+
+		private:
+			void const * id;
+#endif
+		};
+
+
+		template <typename Char>
+		struct OpaqueParser {
+			typedef UniqueOpaque (*Type)(ParseState<Char> &, void const * binding);
+		};
+
+
+		// Converts an occurrence count into the value passed to a counted option's callback.
+		typedef UniqueOpaque (*CountOpaque)(size_t);
+
+		template <typename T>
+		UniqueOpaque OpaqueCount (size_t count)
+		{
+			return UniqueOpaque(AllocateCopy(static_cast<T>(count)).release(), Delete<T>);
+		}
+
+		// How to pass an occurrence count as typeId, or null if typeId is not an integer type.
+		inline CountOpaque CountConverter (TypeId const & typeId)
+		{
+			if (typeId == TypeId::Get<int>()) {
+				return OpaqueCount<int>;
+			}
+			if (typeId == TypeId::Get<unsigned int>()) {
+				return OpaqueCount<unsigned int>;
+			}
+			if (typeId == TypeId::Get<long>()) {
+				return OpaqueCount<long>;
+			}
+			if (typeId == TypeId::Get<unsigned long>()) {
+				return OpaqueCount<unsigned long>;
+			}
+			if (typeId == TypeId::Get<long long>()) {
+				return OpaqueCount<long long>;
+			}
+			if (typeId == TypeId::Get<unsigned long long>()) {
+				return OpaqueCount<unsigned long long>;
+			}
+			return nullptr;
+		}
+
+
+		// The operations on the batch of a collected option, a std::vector<T> of its values, with T erased.
+		class BatchOps {
+		public:
+			UniqueOpaque (*create)();
+			void (*append)(void * batch, void * value);
+			void (*appendAll)(void * batch, void * other);
+			void (*clear)(void * batch);
+			bool (*empty)(void const * batch);
+		};
+
+		template <typename T>
+		struct Batch {
+			typedef std::vector<T> Type;
+
+			static UniqueOpaque Create ()
+			{
+				return UniqueOpaque(new Type(), Delete<Type>);
+			}
+
+			static void Append (void * batch, void * value)
+			{
+				static_cast<Type *>(batch)->push_back(std::move(*static_cast<T *>(value)));
+			}
+
+			static void AppendAll (void * batch, void * other)
+			{
+				Type & from = *static_cast<Type *>(other);
+				Type & to = *static_cast<Type *>(batch);
+				to.insert(to.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+				from.clear();
+			}
+
+			static void Clear (void * batch)
+			{
+				static_cast<Type *>(batch)->clear();
+			}
+
+			static bool Empty (void const * batch)
+			{
+				return static_cast<Type const *>(batch)->empty();
+			}
+
+			static BatchOps Ops ()
+			{
+				BatchOps ops = { Create, Append, AppendAll, Clear, Empty };
+				return ops;
+			}
+		};
+
+
+		// How to parse one callback argument. The binding is per-option state handed to the parser.
+		// The token counts and first-token predicate come from the parsed type's TokenTraits.
+		template <typename Char>
+		class ArgKind {
+		public:
+			typedef bool (*TokenPredicate)(std::basic_string<Char> const &);
+
+			ArgKind (
+				TypeId const & typeId,
+				typename OpaqueParser<Char>::Type parser,
+				size_t minTokens,
+				TokenPredicate canStartWith,
+				std::shared_ptr<void const> const & binding = nullptr)
+				: typeId(typeId)
+				, parser(parser)
+				, minTokens(minTokens)
+				, canStartWith(canStartWith)
+				, binding(binding)
+			{}
+
+			template <typename T>
+			static ArgKind Of (typename OpaqueParser<Char>::Type parser, std::shared_ptr<void const> const & binding = nullptr)
+			{
+				typedef TokenTraits<Char, T> Traits;
+				return ArgKind(TypeId::Get<T>(), parser, Traits::MinTokens, Traits::CanStartWith, binding);
+			}
+
+			bool operator== (ArgKind const & other) const
+			{
+				return typeId == other.typeId;
+			}
+
+			// Whether two arguments parse identically, so overloads can share the parse.
+			bool SameParse (ArgKind const & other) const
+			{
+				return typeId == other.typeId && parser == other.parser && binding == other.binding;
+			}
+
+			// False if parsing cannot succeed at the given argument, or at the end of input when token is null.
+			bool CanStartWith (std::basic_string<Char> const * token) const
+			{
+				if (token == nullptr) {
+					return minTokens == 0;
+				}
+				return minTokens == 0 || canStartWith(*token);
+			}
+
+			UniqueOpaque Parse (ParseState<Char> & parseState) const
+			{
+				return parser(parseState, binding.get());
+			}
+
+		public:
+			TypeId typeId;
+			typename OpaqueParser<Char>::Type parser;
+			size_t minTokens;
+			TokenPredicate canStartWith;
+			std::shared_ptr<void const> binding;
+		};
+
+
+		// The outcome of parsing a type at an argument index, kept while the overloads at one position are tried.
+		class ParseMemo {
+		private:
+			ParseMemo (ParseMemo const &);    // disable
+			void operator= (ParseMemo const &); // disable
+
+		public:
+			ParseMemo (size_t argIndex, TypeId const & typeId, size_t endIndex, size_t highMark, UniqueOpaque && value)
+				: argIndex(argIndex)
+				, typeId(typeId)
+				, endIndex(endIndex)
+				, highMark(highMark)
+				, value(std::move(value))
+			{}
+
+			ParseMemo (ParseMemo && other)
+				: argIndex(other.argIndex)
+				, typeId(other.typeId)
+				, endIndex(other.endIndex)
+				, highMark(other.highMark)
+				, value(std::move(other.value))
+			{}
+
+			bool Failed () const
+			{
+				return endIndex == static_cast<size_t>(-1);
+			}
+
+		public:
+			size_t argIndex;
+			TypeId typeId;
+			size_t endIndex;    // -1 when the parse failed
+			size_t highMark;
+			UniqueOpaque value; // null when the parse failed or its value is in use
+		};
+	}
+
+
+	template <typename Char>
+	class OptInfo {
+	public:
+		typedef std::function<Verdict<Char>(_private::OpaqueValues &)> Callback;
+
+		OptInfo (Keyword<Char> const & keyword, std::vector<_private::ArgKind<Char>> && typeKinds, Callback const & callback)
+			: keyword(keyword)
+			, typeKinds(std::move(typeKinds))
+			, callback(callback)
+			, hits(0)
+			, countSlot(static_cast<size_t>(-1))
+			, batchSlot(static_cast<size_t>(-1))
+			, treeIndex(static_cast<size_t>(-1))
+		{}
+
+		OptInfo (OptInfo && other)
+			: keyword(std::move(other.keyword))
+			, typeKinds(std::move(other.typeKinds))
+			, callback(std::move(other.callback))
+			, hits(other.hits.load())
+			, countSlot(other.countSlot)
+			, batchSlot(other.batchSlot)
+			, treeIndex(other.treeIndex)
+		{}
+
+	public:
+		Keyword<Char> keyword;
+		std::vector<_private::ArgKind<Char>> typeKinds;
+		Callback callback;
+		mutable std::atomic<size_t> hits; // successful matches across all parse contexts
+		size_t countSlot;                 // the position in OptionsImpl::countedFlags of a counted option, or -1
+		size_t batchSlot;                 // the position in OptionsImpl::collectedOptions of a collected option, or -1
+		size_t treeIndex;                 // the position in OptionsImpl::overloadTrees of the tree holding this overload
+	};
+
+
+	namespace _private
+	{
+		// Identifies an overload by its position in OptionsImpl::infosByArity.
+		class OverloadRef {
+		public:
+			OverloadRef (size_t arity, size_t index)
+				: arity(arity)
+				, index(index)
+			{}
+
+			bool operator== (OverloadRef const & other) const
+			{
+				return arity == other.arity && index == other.index;
+			}
+
+			// Overloads with more arguments are tried first, then those registered first.
+			bool PreferredOver (OverloadRef const & other) const
+			{
+				if (arity != other.arity) {
+					return arity > other.arity;
+				}
+				return index < other.index;
+			}
+
+		public:
+			size_t arity;
+			size_t index;
+		};
+
+
+		// The overloads sharing a keyword, with their argument types arranged as a prefix tree.
+		// A prefix of argument types common to several overloads is parsed once during resolution.
+		template <typename Char>
+		class OverloadTree {
+		public:
+			class Node {
+			public:
+				Node (ArgKind<Char> const & kind, OverloadRef const & best)
+					: kind(kind)
+					, best(best)
+					, minTokens(kind.minTokens)
+				{}
+
+				Node (Node && other)
+					: kind(other.kind)
+					, best(other.best)
+					, minTokens(other.minTokens)
+					, children(std::move(other.children))
+					, overloads(std::move(other.overloads))
+				{}
+
+			public:
+				ArgKind<Char> kind;
+				OverloadRef best;                   // the most preferred overload in this subtree
+				size_t minTokens;                   // the fewest arguments any overload in this subtree needs from here on
+				std::vector<size_t> children;       // ordered by preference
+				std::vector<OverloadRef> overloads; // overloads whose arguments end at this node
+			};
+
+			OverloadTree (Keyword<Char> const & keyword, OverloadRef const & ref)
+				: keyword(keyword)
+				, exclusive(true)
+				, overloadCount(0)
+			{
+				nodes.emplace_back(ArgKind<Char>(TypeId::Get<void>(), nullptr, 0, nullptr), ref);
+			}
+
+			OverloadTree (OverloadTree && other)
+				: keyword(std::move(other.keyword))
+				, exclusive(other.exclusive)
+				, overloadCount(other.overloadCount)
+				, nodes(std::move(other.nodes))
+			{}
+
+			void Insert (std::vector<ArgKind<Char>> const & typeKinds, OverloadRef const & ref)
+			{
+				std::vector<size_t> path(1, 0);
+				for (ArgKind<Char> const & typeKind : typeKinds) {
+					size_t const parentIndex = path.back();
+					size_t childIndex = FindChild(parentIndex, typeKind);
+					if (childIndex == nodes.size()) {
+						nodes.emplace_back(typeKind, ref);
+						nodes[parentIndex].children.push_back(childIndex);
+					}
+					path.push_back(childIndex);
+				}
+				nodes[path.back()].overloads.push_back(ref);
+				++overloadCount;
+
+				for (size_t i = path.size(); i-- > 0; ) {
+					Node & node = nodes[path[i]];
+					if (ref.PreferredOver(node.best)) {
+						node.best = ref;
+					}
+					size_t minTokensBelow = node.overloads.empty() ? static_cast<size_t>(-1) : 0;
+					for (size_t childIndex : node.children) {
+						minTokensBelow = std::min(minTokensBelow, nodes[childIndex].minTokens);
+					}
+					node.minTokens = node.kind.minTokens + minTokensBelow;
+					std::stable_sort(node.children.begin(), node.children.end(), [&] (size_t a, size_t b) {
+						return nodes[a].best.PreferredOver(nodes[b].best);
+					});
+				}
+			}
+
+		private:
+			size_t FindChild (size_t nodeIndex, ArgKind<Char> const & typeKind) const
+			{
+				for (size_t childIndex : nodes[nodeIndex].children) {
+					if (nodes[childIndex].kind.SameParse(typeKind)) {
+						return childIndex;
+					}
+				}
+				return nodes.size();
+			}
+
+		public:
+			Keyword<Char> keyword;
+			bool exclusive;          // no other keyword shares a name with this one
+			size_t overloadCount;
+			std::vector<Node> nodes; // the root is nodes[0]
+		};
+
+
+		// A trie of keyword names, used to suggest names close to an unknown option. A query walks the trie while
+		// computing optimal string alignment (restricted Damerau-Levenshtein) distances one row per trie level,
+		// and leaves a subtree as soon as no name below it can be within the bound.
+		template <typename Char>
+		class SuggestionIndex {
+			typedef std::basic_string<Char> String;
+
+		public:
+			class Node {
+			public:
+				explicit Node (Char ch)
+					: ch(ch)
+					, nameIndex(static_cast<size_t>(-1))
+				{}
+
+				Node (Node && other)
+					: ch(other.ch)
+					, nameIndex(other.nameIndex)
+					, children(std::move(other.children))
+				{}
+
+			public:
+				Char ch;
+				size_t nameIndex;             // -1 if no name ends here
+				std::vector<size_t> children;
+			};
+
+			SuggestionIndex ()
+				: maxLength(0)
+			{
+				nodes.emplace_back(Char());
+			}
+
+			SuggestionIndex (SuggestionIndex && other)
+				: nodes(std::move(other.nodes))
+				, names(std::move(other.names))
+				, maxLength(other.maxLength)
+			{}
+
+			void Insert (String const & name)
+			{
+				size_t nodeIndex = 0;
+				for (Char ch : name) {
+					size_t next = nodes.size();
+					for (size_t childIndex : nodes[nodeIndex].children) {
+						if (nodes[childIndex].ch == ch) {
+							next = childIndex;
+							break;
+						}
+					}
+					if (next == nodes.size()) {
+						nodes[nodeIndex].children.push_back(next);
+						nodes.emplace_back(ch);
+					}
+					nodeIndex = next;
+				}
+				if (nodes[nodeIndex].nameIndex == static_cast<size_t>(-1)) {
+					nodes[nodeIndex].nameIndex = names.size();
+					names.push_back(name);
+					maxLength = std::max(maxLength, name.size());
+				}
+			}
+
+			// The names nearest to word, if any are within maxDistance edits, in the order they were added.
+			std::vector<String> Suggest (String const & word, size_t maxDistance, size_t maxCount) const
+			{
+				std::vector<size_t> found;
+				for (size_t bound = 1; bound <= maxDistance && found.empty(); ++bound) {
+					Search(word, bound, found);
+				}
+				std::sort(found.begin(), found.end());
+				std::vector<String> suggestions;
+				for (size_t k = 0; k < found.size() && k < maxCount; ++k) {
+					suggestions.push_back(names[found[k]]);
+				}
+				return suggestions;
+			}
+
+		private:
+			// Adds the index of every name within bound edits of word to found, keeping only the nearest ones.
+			// Row i holds the distances between the first i characters of the trie path and the prefixes of word
+			// whose length is within bound of i, so a row costs 2 * bound + 1 cells however long word is.
+			void Search (String const & word, size_t bound, std::vector<size_t> & found) const
+			{
+				size_t const m = word.size();
+				size_t const width = 2 * bound + 1;
+				size_t const over = bound + 1;
+				size_t best = over;
+				auto consider = [&] (size_t distance, size_t nameIndex) {
+					if (distance < best) {
+						best = distance;
+						found.clear();
+					}
+					if (distance == best) {
+						found.push_back(nameIndex);
+					}
+				};
+
+				// Cell t of row i is the distance to the prefix of word of length i - bound + t.
+				std::vector<size_t> rows((maxLength + 1) * width, over);
+				std::vector<size_t> rowMins(maxLength + 1, 0);
+				std::vector<Char> path(maxLength + 1);
+				for (size_t t = bound; t < width && t - bound <= m; ++t) {
+					rows[t] = t - bound;
+				}
+				if (nodes[0].nameIndex != static_cast<size_t>(-1) && m <= bound) {
+					consider(m, nodes[0].nameIndex);
+				}
+
+				std::vector<std::pair<size_t, size_t>> pending; // (node index, depth)
+				for (size_t childIndex : nodes[0].children) {
+					pending.emplace_back(childIndex, 1);
+				}
+				while (!pending.empty()) {
+					size_t const nodeIndex = pending.back().first;
+					size_t const i = pending.back().second;
+					pending.pop_back();
+					Node const & node = nodes[nodeIndex];
+
+					path[i] = node.ch;
+					size_t const * prev2 = i > 1 ? &rows[(i - 2) * width] : nullptr;
+					size_t const * prev = &rows[(i - 1) * width];
+					size_t * curr = &rows[i * width];
+
+					// Only cells for prefixes of length 0 to m exist; the rest stay at over.
+					size_t const tBegin = i < bound ? bound - i : 0;
+					size_t const tEnd = m + bound + 1 > i ? std::min(width, m + bound + 1 - i) : 0;
+					std::fill(curr, curr + width, over);
+					size_t rowMin = over;
+					for (size_t t = tBegin; t < tEnd; ++t) {
+						size_t const j = i + t - bound;
+						size_t d;
+						if (j == 0) {
+							d = i;
+						}
+						else {
+							d = prev[t] + (path[i] == word[j - 1] ? 0 : 1);
+							if (t + 1 < width) {
+								d = std::min(d, prev[t + 1] + 1);
+							}
+							if (t > 0) {
+								d = std::min(d, curr[t - 1] + 1);
+							}
+							if (prev2 != nullptr && j > 1 && path[i] == word[j - 2] && path[i - 1] == word[j - 1]) {
+								d = std::min(d, prev2[t] + 1);
+							}
+						}
+						curr[t] = std::min(d, over);
+						rowMin = std::min(rowMin, curr[t]);
+					}
+					rowMins[i] = rowMin;
+
+					if (node.nameIndex != static_cast<size_t>(-1) && m + bound >= i && m + bound - i < width) {
+						size_t const d = curr[m + bound - i];
+						if (d <= bound) {
+							consider(d, node.nameIndex);
+						}
+					}
+					// A deeper row is at least this row's minimum, or the previous row's minimum plus one.
+					if (rowMin > bound && rowMins[i - 1] >= bound) {
+						continue;
+					}
+					for (size_t childIndex : node.children) {
+						pending.emplace_back(childIndex, i + 1);
+					}
+				}
+			}
+
+		private:
+			std::vector<Node> nodes; // the root is nodes[0]
+			std::vector<String> names;
+			size_t maxLength;        // the depth of the trie
+		};
+
+		// Maps the character of each short keyword name (such as "-x") to what a GNU short-option group does with it.
+		// Characters below 256 are looked up directly; wider ones are binary searched.
+		template <typename Char>
+		class ShortOptionTable {
+		public:
+			class Entry {
+			public:
+				Entry ()
+					: direct(0, static_cast<size_t>(-1))
+					, nested(false)
+					, tree(static_cast<size_t>(-1))
+					, sharedTree(false)
+				{}
+
+				// Whether the character can match without arguments, making it a flag within a group.
+				bool Alone () const
+				{
+					return nested || direct.index != static_cast<size_t>(-1);
+				}
+
+			public:
+				OverloadRef direct; // the zero-arity overload, if it is the only one that can match without arguments
+				bool nested;        // an overload with arguments could match without any, so parse the character alone
+				size_t tree;        // the overload tree of the keyword with this name
+				bool sharedTree;    // several keywords have this name, so values are not taken within a group
+			};
+
+			ShortOptionTable ()
+			{
+				narrow.fill(static_cast<size_t>(-1));
+			}
+
+			ShortOptionTable (ShortOptionTable && other)
+				: narrow(other.narrow)
+				, wide(std::move(other.wide))
+				, entries(std::move(other.entries))
+			{}
+
+			Entry const * Find (Char c) const
+			{
+				size_t const index = IndexOf(c);
+				return index == static_cast<size_t>(-1) ? nullptr : &entries[index];
+			}
+
+			Entry & Get (Char c)
+			{
+				size_t index = IndexOf(c);
+				if (index == static_cast<size_t>(-1)) {
+					index = entries.size();
+					entries.emplace_back();
+					if (Unsigned(c) < narrow.size()) {
+						narrow[Unsigned(c)] = index;
+					}
+					else {
+						auto const it = std::lower_bound(wide.begin(), wide.end(), std::make_pair(c, size_t(0)));
+						wide.insert(it, std::make_pair(c, index));
+					}
+				}
+				return entries[index];
+			}
+
+		private:
+			typedef typename std::make_unsigned<Char>::type UChar;
+
+			static UChar Unsigned (Char c)
+			{
+				return static_cast<UChar>(c);
+			}
+
+			size_t IndexOf (Char c) const
+			{
+				if (Unsigned(c) < narrow.size()) {
+					return narrow[Unsigned(c)];
+				}
+				auto const it = std::lower_bound(wide.begin(), wide.end(), std::make_pair(c, size_t(0)));
+				return it != wide.end() && it->first == c ? it->second : static_cast<size_t>(-1);
+			}
+
+		private:
+			std::array<size_t, 256> narrow;           // entry index, or -1
+			std::vector<std::pair<Char, size_t>> wide; // sorted by character
+			std::vector<Entry> entries;
+		};
+
+		// A trie of the prefixes of joined options (see Keyword::Prefix), looked up by the longest prefix of an argument.
+		// The children of each node are sorted by character and binary searched.
+		template <typename Char>
+		class PrefixTrie {
+			typedef std::basic_string<Char> String;
+
+		public:
+			class Node {
+			public:
+				Node ()
+				{}
+
+				Node (Node && other)
+					: trees(std::move(other.trees))
+					, children(std::move(other.children))
+				{}
+
+			public:
+				std::vector<size_t> trees;                     // the overload trees of the keywords with this prefix
+				std::vector<std::pair<Char, size_t>> children; // sorted by character
+			};
+
+			PrefixTrie ()
+			{
+				nodes.emplace_back();
+			}
+
+			PrefixTrie (PrefixTrie && other)
+				: nodes(std::move(other.nodes))
+			{}
+
+			void Insert (String const & prefix, size_t treeIndex)
+			{
+				size_t nodeIndex = 0;
+				for (Char ch : prefix) {
+					auto & children = nodes[nodeIndex].children;
+					auto const it = std::lower_bound(children.begin(), children.end(), std::make_pair(ch, size_t(0)));
+					if (it != children.end() && it->first == ch) {
+						nodeIndex = it->second;
+					}
+					else {
+						nodeIndex = nodes.size();
+						children.insert(it, std::make_pair(ch, nodeIndex));
+						nodes.emplace_back();
+					}
+				}
+				auto & trees = nodes[nodeIndex].trees;
+				if (std::find(trees.begin(), trees.end(), treeIndex) == trees.end()) {
+					trees.push_back(treeIndex);
+				}
+			}
+
+			// The length of the longest prefix inserted that begins arg and is no longer than limit, or 0 if there is none.
+			// Sets node to the node of that prefix.
+			size_t Longest (String const & arg, size_t limit, Node const * & node) const
+			{
+				size_t length = 0;
+				size_t nodeIndex = 0;
+				for (size_t i = 0; i < limit && i < arg.size(); ++i) {
+					auto const & children = nodes[nodeIndex].children;
+					auto const it = std::lower_bound(children.begin(), children.end(), std::make_pair(arg[i], size_t(0)));
+					if (it == children.end() || it->first != arg[i]) {
+						break;
+					}
+					nodeIndex = it->second;
+					if (!nodes[nodeIndex].trees.empty()) {
+						length = i + 1;
+						node = &nodes[nodeIndex];
+					}
+				}
+				return length;
+			}
+
+		private:
+			std::vector<Node> nodes; // the root is nodes[0]
+		};
+
+		// The characters an argument matching a keyword name or prefix can start with. An argument starting with any
+		// other character cannot be an option, so runs of positional arguments are found without looking them up.
+		template <typename Char>
+		class LeadCharacters {
+			typedef std::basic_string<Char> String;
+
+		public:
+			LeadCharacters ()
+				: empty(false)
+			{
+				narrow.fill(false);
+			}
+
+			LeadCharacters (LeadCharacters && other)
+				: narrow(other.narrow)
+				, wide(std::move(other.wide))
+				, empty(other.empty)
+			{}
+
+			void InsertName (String const & name, MatchFlags flags)
+			{
+				if (!name.empty() && name[0] == '-') {
+					Insert('-');
+					return;
+				}
+				// Leading dashes are counted exactly, but other relaxed characters can be skipped on either side.
+				bool const relaxedDashes = (flags & MatchFlags::RelaxedDashes) != MatchFlags::Empty;
+				bool const relaxedUnderscores = (flags & MatchFlags::RelaxedUnderscores) != MatchFlags::Empty;
+				if (relaxedUnderscores) {
+					Insert('_');
+				}
+				size_t i = 0;
+				while (i < name.size() && ((relaxedDashes && name[i] == '-') || (relaxedUnderscores && name[i] == '_'))) {
+					++i;
+				}
+				if (i == name.size()) {
+					empty = true;
+					return;
+				}
+				Char const c = name[i];
+				Insert(c);
+				if ((flags & MatchFlags::IgnoreAsciiCase) != MatchFlags::Empty) {
+					if ('a' <= c && c <= 'z') {
+						Insert(static_cast<Char>(c - 'a' + 'A'));
+					}
+					else if ('A' <= c && c <= 'Z') {
+						Insert(static_cast<Char>(c - 'A' + 'a'));
+					}
+				}
+			}
+
+			void InsertPrefix (String const & prefix)
+			{
+				Insert(prefix[0]);
+			}
+
+			bool MayStart (String const & arg) const
+			{
+				if (arg.empty()) {
+					return empty;
+				}
+				Char const c = arg[0];
+				if (Unsigned(c) < narrow.size()) {
+					return narrow[Unsigned(c)];
+				}
+				return std::binary_search(wide.begin(), wide.end(), c);
+			}
+
+		private:
+			typedef typename std::make_unsigned<Char>::type UChar;
+
+			static UChar Unsigned (Char c)
+			{
+				return static_cast<UChar>(c);
+			}
+
+			void Insert (Char c)
+			{
+				if (Unsigned(c) < narrow.size()) {
+					narrow[Unsigned(c)] = true;
+				}
+				else {
+					auto const it = std::lower_bound(wide.begin(), wide.end(), c);
+					if (it == wide.end() || *it != c) {
+						wide.insert(it, c);
+					}
+				}
+			}
+
+		private:
+			std::array<bool, 256> narrow;
+			std::vector<Char> wide; // sorted
+			bool empty;             // whether an empty argument may match
+		};
+	}
+
+
+	template <typename Func>
+	struct FuncTraits : public FuncTraits<decltype(&Func::operator())> {};
+
+	template <typename R>
+	struct FuncTraits<R()> {
+		enum { arity = 0 };
+		struct Return { typedef R type; };
+	};
+
+	template <typename R, typename A>
+	struct FuncTraits<R(A)> : FuncTraits<R()> {
+		enum { arity = 1 };
+		struct Arg0 { typedef A type; };
+	};
+
+	template <typename R, typename A, typename B>
+	struct FuncTraits<R(A, B)> : FuncTraits<R(A)> {
+		enum { arity = 2 };
+		struct Arg1 { typedef B type; };
+	};
+
+	template <typename R, typename A, typename B, typename C>
+	struct FuncTraits<R(A, B, C)> : FuncTraits<R(A, B)> {
+		enum { arity = 3 };
+		struct Arg2 { typedef C type; };
+	};
+
+	template <typename R, typename A, typename B, typename C, typename D>
+	struct FuncTraits<R(A, B, C, D)> : FuncTraits<R(A, B, C)> {
+		enum { arity = 4 };
+		struct Arg3 { typedef D type; };
+	};
+
+	template <typename R, typename A, typename B, typename C, typename D, typename E>
+	struct FuncTraits<R(A, B, C, D, E)> : FuncTraits<R(A, B, C, D)> {
+		enum { arity = 5 };
+		struct Arg4 { typedef E type; };
+	};
+
+	template <typename R, typename A, typename B, typename C, typename D, typename E, typename F>
+	struct FuncTraits<R(A, B, C, D, E, F)> : FuncTraits<R(A, B, C, D, E)> {
+		enum { arity = 6 };
+		struct Arg5 { typedef F type; };
+	};
+
+	template <typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G>
+	struct FuncTraits<R(A, B, C, D, E, F, G)> : FuncTraits<R(A, B, C, D, E, F)> {
+		enum { arity = 7 };
+		struct Arg6 { typedef G type; };
+	};
+
+	template <typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H>
+	struct FuncTraits<R(A, B, C, D, E, F, G, H)> : FuncTraits<R(A, B, C, D, E, F, G)> {
+		enum { arity = 8 };
+		struct Arg7 { typedef H type; };
+	};
+
+	template <typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H, typename I>
+	struct FuncTraits<R(A, B, C, D, E, F, G, H, I)> : FuncTraits<R(A, B, C, D, E, F, G, H)> {
+		enum { arity = 9 };
+		struct Arg8 { typedef I type; };
+	};
+
+	template <typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H, typename I, typename J>
+	struct FuncTraits<R(A, B, C, D, E, F, G, H, I, J)> : FuncTraits<R(A, B, C, D, E, F, G, H, I)> {
+		enum { arity = 10 };
+		struct Arg9 { typedef J type; };
+	};
+
+	template <typename X, typename R>
+	struct FuncTraits<R(X::*)() const> {
+		enum { arity = 0 };
+		struct Return { typedef R type; };
+	};
+
+	template <typename X, typename R, typename A>
+	struct FuncTraits<R(X::*)(A) const> : FuncTraits<R(X::*)() const> {
+		enum { arity = 1 };
+		struct Arg0 { typedef A type; };
+	};
+
+	template <typename X, typename R, typename A, typename B>
+	struct FuncTraits<R(X::*)(A, B) const> : FuncTraits<R(X::*)(A) const> {
+		enum { arity = 2 };
+		struct Arg1 { typedef B type; };
+	};
+
+	template <typename X, typename R, typename A, typename B, typename C>
+	struct FuncTraits<R(X::*)(A, B, C) const> : FuncTraits<R(X::*)(A, B) const> {
+		enum { arity = 3 };
+		struct Arg2 { typedef C type; };
+	};
+
+	template <typename X, typename R, typename A, typename B, typename C, typename D>
+	struct FuncTraits<R(X::*)(A, B, C, D) const> : FuncTraits<R(X::*)(A, B, C) const> {
+		enum { arity = 4 };
+		struct Arg3 { typedef D type; };
+	};
+
+	template <typename X, typename R, typename A, typename B, typename C, typename D, typename E>
+	struct FuncTraits<R(X::*)(A, B, C, D, E) const> : FuncTraits<R(X::*)(A, B, C, D) const> {
+		enum { arity = 5 };
+		struct Arg4 { typedef E type; };
+	};
+
+	template <typename X, typename R, typename A, typename B, typename C, typename D, typename E, typename F>
+	struct FuncTraits<R(X::*)(A, B, C, D, E, F) const> : FuncTraits<R(X::*)(A, B, C, D, E) const> {
+		enum { arity = 6 };
+		struct Arg5 { typedef F type; };
+	};
+
+	template <typename X, typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G>
+	struct FuncTraits<R(X::*)(A, B, C, D, E, F, G) const> : FuncTraits<R(X::*)(A, B, C, D, E, F) const> {
+		enum { arity = 7 };
+		struct Arg6 { typedef G type; };
+	};
+
+	template <typename X, typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H>
+	struct FuncTraits<R(X::*)(A, B, C, D, E, F, G, H) const> : FuncTraits<R(X::*)(A, B, C, D, E, F, G) const> {
+		enum { arity = 8 };
+		struct Arg7 { typedef H type; };
+	};
+
+	template <typename X, typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H, typename I>
+	struct FuncTraits<R(X::*)(A, B, C, D, E, F, G, H, I) const> : FuncTraits<R(X::*)(A, B, C, D, E, F, G, H) const> {
+		enum { arity = 9 };
+		struct Arg8 { typedef I type; };
+	};
+
+	template <typename X, typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H, typename I, typename J>
+	struct FuncTraits<R(X::*)(A, B, C, D, E, F, G, H, I, J) const> : FuncTraits<R(X::*)(A, B, C, D, E, F, G, H, I) const> {
+		enum { arity = 10 };
+		struct Arg9 { typedef J type; };
+	};
+
+
+	namespace _private
+	{
+		template <typename Char>
+		class OptionsImpl {
+		public:
+			typedef std::basic_string<Char> String;
+			typedef LAMBDA_OPTIONS_NAMESPACE::Keyword<Char> Keyword;
+			typedef std::function<Verdict<Char>(Span<String const>)> BatchHandler;
+
+
+			OptionsImpl (OptionsConfig const & config)
+				: config(config)
+				, keywordlessTree(static_cast<size_t>(-1))
+			{}
+
+
+			String HelpDescription (FormattingConfig<Char> const & config) const;
+
+
+			void SetHelpGroupPriority (String const & helpGroup, Priority priority)
+			{
+				Priority * p = _private::Lookup(helpGroupPriorities, helpGroup);
+				if (p == nullptr) {
+					helpGroupPriorities.emplace_back(helpGroup, priority);
+				}
+				else {
+					*p = priority;
+				}
+			}
+
+
+			template <typename Func, size_t N>
+			struct Adder {};
+
+
+			template <typename Func>
+			struct Adder<Func, 0> {
+				static OptionError Add (OptionsImpl & opts, Keyword const & keyword, Func const & f)
+				{
+					typedef typename FuncTraits<Func>::Return::type R;
+					return opts.template AddImpl<R>(keyword, f);
+				}
+			};
+
+
+			template <typename Func>
+			struct Adder<Func, 1> {
+				static OptionError Add (OptionsImpl & opts, Keyword const & keyword, Func const & f)
+				{
+					typedef typename FuncTraits<Func>::Arg0::type A;
+					typedef typename FuncTraits<Func>::Return::type R;
+					return opts.template AddImpl<R, A>(keyword, f);
+				}
+			};
+
+
+			template <typename Func>
+			struct Adder<Func, 2> {
+				static OptionError Add (OptionsImpl & opts, Keyword const & keyword, Func const & f)
+				{
+					typedef typename FuncTraits<Func>::Arg0::type A;
+					typedef typename FuncTraits<Func>::Arg1::type B;
+					typedef typename FuncTraits<Func>::Return::type R;
+					return opts.template AddImpl<R, A,B>(keyword, f);
+				}
+			};
+
+
+			template <typename Func>
+			struct Adder<Func, 3> {
+				static OptionError Add (OptionsImpl & opts, Keyword const & keyword, Func const & f)
+				{
+					typedef typename FuncTraits<Func>::Arg0::type A;
+					typedef typename FuncTraits<Func>::Arg1::type B;
+					typedef typename FuncTraits<Func>::Arg2::type C;
+					typedef typename FuncTraits<Func>::Return::type R;
+					return opts.template AddImpl<R, A,B,C>(keyword, f);
+				}
+			};
+
+
+			template <typename Func>
+			struct Adder<Func, 4> {
+				static OptionError Add (OptionsImpl & opts, Keyword const & keyword, Func const & f)
+				{
+					typedef typename FuncTraits<Func>::Arg0::type A;
+					typedef typename FuncTraits<Func>::Arg1::type B;
+					typedef typename FuncTraits<Func>::Arg2::type C;
+					typedef typename FuncTraits<Func>::Arg3::type D;
+					typedef typename FuncTraits<Func>::Return::type R;
+					return opts.template AddImpl<R, A,B,C,D>(keyword, f);
+				}
+			};
+
+
+			template <typename Func>
+			struct Adder<Func, 5> {
+				static OptionError Add (OptionsImpl & opts, Keyword const & keyword, Func const & f)
+				{
+					typedef typename FuncTraits<Func>::Arg0::type A;
+					typedef typename FuncTraits<Func>::Arg1::type B;
+					typedef typename FuncTraits<Func>::Arg2::type C;
+					typedef typename FuncTraits<Func>::Arg3::type D;
+					typedef typename FuncTraits<Func>::Arg4::type E;
+					typedef typename FuncTraits<Func>::Return::type R;
+					return opts.template AddImpl<R, A,B,C,D,E>(keyword, f);
+				}
+			};
+
+
+			template <typename Func>
+			struct Adder<Func, 6> {
+				static OptionError Add(OptionsImpl & opts, Keyword const & keyword, Func const & f)
+				{
+					typedef typename FuncTraits<Func>::Arg0::type A;
+					typedef typename FuncTraits<Func>::Arg1::type B;
+					typedef typename FuncTraits<Func>::Arg2::type C;
+					typedef typename FuncTraits<Func>::Arg3::type D;
+					typedef typename FuncTraits<Func>::Arg4::type E;
+					typedef typename FuncTraits<Func>::Arg5::type F;
+					typedef typename FuncTraits<Func>::Return::type R;
+					return opts.template AddImpl<R, A, B, C, D, E, F>(keyword, f);
+				}
+			};
+
+
+			template <typename Func>
+			struct Adder<Func, 7> {
+				static OptionError Add(OptionsImpl & opts, Keyword const & keyword, Func const & f)
+				{
+					typedef typename FuncTraits<Func>::Arg0::type A;
+					typedef typename FuncTraits<Func>::Arg1::type B;
+					typedef typename FuncTraits<Func>::Arg2::type C;
+					typedef typename FuncTraits<Func>::Arg3::type D;
+					typedef typename FuncTraits<Func>::Arg4::type E;
+					typedef typename FuncTraits<Func>::Arg5::type F;
+					typedef typename FuncTraits<Func>::Arg6::type G;
+					typedef typename FuncTraits<Func>::Return::type R;
+					return opts.template AddImpl<R, A, B, C, D, E, F, G>(keyword, f);
+				}
+			};
+
+
+			template <typename Func>
+			struct Adder<Func, 8> {
+				static OptionError Add(OptionsImpl & opts, Keyword const & keyword, Func const & f)
+				{
+					typedef typename FuncTraits<Func>::Arg0::type A;
+					typedef typename FuncTraits<Func>::Arg1::type B;
+					typedef typename FuncTraits<Func>::Arg2::type C;
+					typedef typename FuncTraits<Func>::Arg3::type D;
+					typedef typename FuncTraits<Func>::Arg4::type E;
+					typedef typename FuncTraits<Func>::Arg5::type F;
+					typedef typename FuncTraits<Func>::Arg6::type G;
+					typedef typename FuncTraits<Func>::Arg7::type H;
+					typedef typename FuncTraits<Func>::Return::type R;
+					return opts.template AddImpl<R, A, B, C, D, E, F, G, H>(keyword, f);
+				}
+			};
+
+
+			template <typename Func>
+			struct Adder<Func, 9> {
+				static OptionError Add(OptionsImpl & opts, Keyword const & keyword, Func const & f)
+				{
+					typedef typename FuncTraits<Func>::Arg0::type A;
+					typedef typename FuncTraits<Func>::Arg1::type B;
+					typedef typename FuncTraits<Func>::Arg2::type C;
+					typedef typename FuncTraits<Func>::Arg3::type D;
+					typedef typename FuncTraits<Func>::Arg4::type E;
+					typedef typename FuncTraits<Func>::Arg5::type F;
+					typedef typename FuncTraits<Func>::Arg6::type G;
+					typedef typename FuncTraits<Func>::Arg7::type H;
+					typedef typename FuncTraits<Func>::Arg8::type I;
+					typedef typename FuncTraits<Func>::Return::type R;
+					return opts.template AddImpl<R, A, B, C, D, E, F, G, H, I>(keyword, f);
+				}
+			};
+
+
+			template <typename Func>
+			struct Adder<Func, 10> {
+				static OptionError Add(OptionsImpl & opts, Keyword const & keyword, Func const & f)
+				{
+					typedef typename FuncTraits<Func>::Arg0::type A;
+					typedef typename FuncTraits<Func>::Arg1::type B;
+					typedef typename FuncTraits<Func>::Arg2::type C;
+					typedef typename FuncTraits<Func>::Arg3::type D;
+					typedef typename FuncTraits<Func>::Arg4::type E;
+					typedef typename FuncTraits<Func>::Arg5::type F;
+					typedef typename FuncTraits<Func>::Arg6::type G;
+					typedef typename FuncTraits<Func>::Arg7::type H;
+					typedef typename FuncTraits<Func>::Arg8::type I;
+					typedef typename FuncTraits<Func>::Arg9::type J;
+					typedef typename FuncTraits<Func>::Return::type R;
+					return opts.template AddImpl<R, A, B, C, D, E, F, G, H, I, J>(keyword, f);
+				}
+			};
+
+
+			template <typename Func>
+			OptionError AddOption (Keyword const & keyword, Func const & f)
+			{
+				Keyword kw = MassageKeyword(keyword);
+				return Adder<Func, FuncTraits<Func>::arity>::Add(*this, kw, f);
+			}
+
+
+			Keyword MassageKeyword (Keyword const & proto)
+			{
+				Keyword kw(proto);
+				std::vector<String> & names = kw.names;
+				for (String & name : names) {
+					switch (config.keywordStyle) {
+						case KeywordStyle::Exact: {
+							continue;
+						} break;
+						case KeywordStyle::Gnu: {
+							if (name.size() == 1) {
+								name.insert(0, 1, '-');
+							}
+							else if (name.size() == 2 && name[0] == '-') {
+								continue;
+							}
+							else {
+								while (!_private::IsPrefixOf("--", name)) {
+									name.insert(0, 1, '-');
+								}
+							}
+						} break;
+						case KeywordStyle::Windows: {
+							if (name.size() >= 1 && name[0] == '/') {
+								continue;
+							}
+							name.insert(0, 1, '/');
+						} break;
+						default: {
+							Assert(__LINE__, false);
+						}
+					}
+				}
+
+				std::vector<String> & exactNames = kw.exactNames;
+				names.insert(names.end(), exactNames.begin(), exactNames.end());
+				exactNames.clear();
+
+				std::vector<String> & negatedNames = kw.negatedNames;
+				negatedNames.clear();
+				if (kw.negatable) {
+					for (String const & name : names) {
+						size_t start = 0;
+						while (start < name.size() && (name[start] == '-' || name[start] == '/')) {
+							++start;
+						}
+						if (start + 1 < name.size()) {
+							negatedNames.push_back(name);
+							negatedNames.back().insert(start, _private::StringLiteral<Char>::no());
+						}
+					}
+					std::sort(negatedNames.begin(), negatedNames.end());
+					negatedNames.erase(std::unique(negatedNames.begin(), negatedNames.end()), negatedNames.end());
+					names.insert(names.end(), negatedNames.begin(), negatedNames.end());
+				}
+
+				std::sort(names.begin(), names.end());
+				auto it = std::unique(names.begin(), names.end());
+				names.erase(it, names.end());
+
+				std::vector<String> & prefixes = kw.prefixes;
+				std::sort(prefixes.begin(), prefixes.end());
+				prefixes.erase(std::unique(prefixes.begin(), prefixes.end()), prefixes.end());
+
+				return kw;
+			}
+
+
+			bool Intersecting (Keyword const & kw1, Keyword const & kw2, size_t & i, size_t & j) const
+			{
+				Assert(__LINE__, kw1.exactNames.empty());
+				Assert(__LINE__, kw2.exactNames.empty());
+
+				for (i = 0; i < kw1.names.size(); ++i) {
+					String const & name = kw1.names[i];
+					for (j = 0; j < kw2.names.size(); ++j) {
+						String const & otherName = kw2.names[j];
+						if (MatchesName(config.matchFlags, name, otherName)) {
+							return true;
+						}
+					}
+				}
+				return false;
+			}
+
+
+			static bool SharingPrefix (Keyword const & kw1, Keyword const & kw2, size_t & i, size_t & j)
+			{
+				for (i = 0; i < kw1.prefixes.size(); ++i) {
+					auto const it = std::find(kw2.prefixes.begin(), kw2.prefixes.end(), kw1.prefixes[i]);
+					if (it != kw2.prefixes.end()) {
+						j = static_cast<size_t>(it - kw2.prefixes.begin());
+						return true;
+					}
+				}
+				return false;
+			}
+
+
+			static bool Keywordless (Keyword const & keyword)
+			{
+				return keyword.names.empty() && keyword.prefixes.empty();
+			}
+
+
+			// Whether str begins with prefix. A name is compared ignoring ASCII case when names match that way.
+			bool BeginsWith (String const & str, String const & prefix, bool isName) const
+			{
+				if (str.size() < prefix.size()) {
+					return false;
+				}
+				for (size_t k = 0; k < prefix.size(); ++k) {
+					if (isName ? ShortOptionKey(str[k]) != ShortOptionKey(prefix[k]) : str[k] != prefix[k]) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			// Finds a prefix of kw1 and a name or prefix of kw2 that the same argument could start with.
+			// Sets first and second to them.
+			bool OverlappingPrefix (Keyword const & kw1, Keyword const & kw2, String const * & first, String const * & second) const
+			{
+				for (String const & prefix : kw1.prefixes) {
+					for (String const & other : kw2.prefixes) {
+						if (BeginsWith(prefix, other, false) || BeginsWith(other, prefix, false)) {
+							first = &prefix;
+							second = &other;
+							return true;
+						}
+					}
+					for (String const & name : kw2.names) {
+						if (BeginsWith(name, prefix, true)) {
+							first = &prefix;
+							second = &name;
+							return true;
+						}
+					}
+				}
+				return false;
+			}
+
+
+			OptionError CheckAmbiguous (Keyword const & keyword) const
+			{
+				for (auto const & tree : overloadTrees) {
+					size_t i = 0;
+					size_t j = 0;
+					if ((Keywordless(keyword) && Keywordless(tree.keyword)) || Intersecting(keyword, tree.keyword, i, j)) {
+#ifndef LAMBDA_OPTIONS_NO_THROW
+						if (Keywordless(keyword)) {
+							throw AmbiguousOptionException<Char>(String(), String());
+						}
+						throw AmbiguousOptionException<Char>(keyword.names[i], tree.keyword.names[j]);
+#else
+						return OptionError::AmbiguousOption;
+#endif
+					}
+					String const * first;
+					String const * second;
+					if (OverlappingPrefix(keyword, tree.keyword, first, second) || OverlappingPrefix(tree.keyword, keyword, second, first)) {
+#ifndef LAMBDA_OPTIONS_NO_THROW
+						throw AmbiguousOptionException<Char>(*first, *second);
+#else
+						return OptionError::AmbiguousOption;
+#endif
+					}
+				}
+				return OptionError::None;
+			}
+
+			OptionError NewInfo (Keyword const & keyword, std::vector<ArgKind<Char>> & typeKinds, typename OptInfo<Char>::Callback const & func, size_t arity)
+			{
+				OverloadRef ref(0, 0);
+				return NewInfo(keyword, typeKinds, func, arity, ref);
+			}
+
+			// As above, setting ref to the overload that was added.
+			OptionError NewInfo (Keyword const & keyword, std::vector<ArgKind<Char>> & typeKinds, typename OptInfo<Char>::Callback const & func, size_t arity, OverloadRef & ref)
+			{
+				if (keyword.negatable) {
+					// The bool is supplied by the parse context from the name given, so the option takes no arguments.
+					if (arity != 1 || !(typeKinds[0].typeId == TypeId::Get<bool>())) {
+#ifndef LAMBDA_OPTIONS_NO_THROW
+						throw NegatableSignatureException();
+#else
+						return OptionError::NegatableSignature;
+#endif
+					}
+					if (keyword.names.empty()) {
+#ifndef LAMBDA_OPTIONS_NO_THROW
+						throw EmptyOptionException();
+#else
+						return OptionError::EmptyOption;
+#endif
+					}
+					typeKinds.clear();
+					arity = 0;
+				}
+				CountOpaque countOpaque = nullptr;
+				if (keyword.counted) {
+					// The count is passed once parsing ends, so the option takes no arguments.
+					countOpaque = arity == 1 ? CountConverter(typeKinds[0].typeId) : nullptr;
+					if (countOpaque == nullptr) {
+#ifndef LAMBDA_OPTIONS_NO_THROW
+						throw CountedSignatureException();
+#else
+						return OptionError::CountedSignature;
+#endif
+					}
+					typeKinds.clear();
+					arity = 0;
+				}
+				if (infosByArity.size() <= arity) {
+					infosByArity.resize(arity + 1);
+				}
+				for (String const & prefix : keyword.prefixes) {
+					if (prefix.empty()) {
+#ifndef LAMBDA_OPTIONS_NO_THROW
+						throw EmptyOptionException();
+#else
+						return OptionError::EmptyOption;
+#endif
+					}
+				}
+				auto & infos = infosByArity[arity];
+				for (auto & info : infos) {
+					size_t i;
+					size_t j;
+					if (info.typeKinds != typeKinds) {
+						continue;
+					}
+					if (Intersecting(keyword, info.keyword, i, j)) {
+#ifndef LAMBDA_OPTIONS_NO_THROW
+						throw OptionConflictException<Char>(keyword.names[i], info.keyword.names[j], arity);
+#else
+						return OptionError::OptionConflict;
+#endif
+					}
+					if (SharingPrefix(keyword, info.keyword, i, j)) {
+#ifndef LAMBDA_OPTIONS_NO_THROW
+						throw OptionConflictException<Char>(keyword.prefixes[i], info.keyword.prefixes[j], arity);
+#else
+						return OptionError::OptionConflict;
+#endif
+					}
+				}
+				if (config.deterministic) {
+					OptionError const error = CheckAmbiguous(keyword);
+					if (error != OptionError::None) {
+						return error;
+					}
+				}
+				infos.emplace_back(keyword, std::move(typeKinds), func);
+
+				ref = OverloadRef(arity, infos.size() - 1);
+				if (countOpaque != nullptr) {
+					infos.back().countSlot = countedFlags.size();
+					countedFlags.emplace_back(ref, countOpaque);
+				}
+				for (size_t treeIndex = 0; treeIndex < overloadTrees.size(); ++treeIndex) {
+					auto & tree = overloadTrees[treeIndex];
+					if (tree.keyword.names == keyword.names && tree.keyword.prefixes == keyword.prefixes) {
+						tree.Insert(infos.back().typeKinds, ref);
+						infos.back().treeIndex = treeIndex;
+						registrations.emplace_back(ref, treeIndex);
+						AddShortOption(infos.back(), ref, treeIndex);
+						return OptionError::None;
+					}
+				}
+
+				OverloadTree<Char> tree(keyword, ref);
+				tree.Insert(infos.back().typeKinds, ref);
+				if (Keywordless(keyword)) {
+					keywordlessTree = overloadTrees.size();
+				}
+				else if (!keyword.names.empty()) {
+					for (size_t treeIndex : keywordTreeOrder) {
+						auto & other = overloadTrees[treeIndex];
+						size_t i;
+						size_t j;
+						if (Intersecting(keyword, other.keyword, i, j)) {
+							other.exclusive = false;
+							tree.exclusive = false;
+						}
+					}
+					keywordTreeOrder.push_back(overloadTrees.size());
+					for (String const & name : keyword.names) {
+						suggestionIndex.Insert(name);
+						leadCharacters.InsertName(name, config.matchFlags);
+					}
+				}
+				for (String const & prefix : keyword.prefixes) {
+					joinedPrefixes.Insert(prefix, overloadTrees.size());
+					leadCharacters.InsertPrefix(prefix);
+				}
+				infos.back().treeIndex = overloadTrees.size();
+				registrations.emplace_back(ref, overloadTrees.size());
+				overloadTrees.emplace_back(std::move(tree));
+				AddShortOption(infos.back(), ref, overloadTrees.size() - 1);
+				return OptionError::None;
+			}
+
+			// The key of c in shortOptions. Keys are case-folded when names ignore ASCII case.
+			Char ShortOptionKey (Char c) const
+			{
+				if ((config.matchFlags & MatchFlags::IgnoreAsciiCase) != MatchFlags::Empty && 'A' <= c && c <= 'Z') {
+					return static_cast<Char>(c - 'A' + 'a');
+				}
+				return c;
+			}
+
+			// Finds the c for which the argument "-c" matches name, if there is one.
+			bool ShortName (String const & name, Char & c) const
+			{
+				MatchFlags const flags = config.matchFlags;
+				auto skippable = [flags] (Char ch) {
+					return (ch == '-' && (flags & MatchFlags::RelaxedDashes) != MatchFlags::Empty)
+						|| (ch == '_' && (flags & MatchFlags::RelaxedUnderscores) != MatchFlags::Empty);
+				};
+				if (name.size() < 2 || name[0] != '-' || name[1] == '-') {
+					return false;
+				}
+				size_t i = 1;
+				while (i < name.size() && skippable(name[i])) {
+					++i;
+				}
+				if (i == name.size()) {
+					return false;
+				}
+				c = name[i++];
+				while (i < name.size() && skippable(name[i])) {
+					++i;
+				}
+				String arg(2, '-');
+				arg[1] = c;
+				return i == name.size() && MatchesName(flags, arg, name);
+			}
+
+			void AddShortOption (OptInfo<Char> const & info, OverloadRef const & ref, size_t treeIndex)
+			{
+				bool canMatchAlone = true;
+				for (auto const & typeKind : info.typeKinds) {
+					canMatchAlone = canMatchAlone && typeKind.minTokens == 0;
+				}
+				for (String const & name : info.keyword.names) {
+					Char c;
+					if (!ShortName(name, c)) {
+						continue;
+					}
+					auto & entry = shortOptions.Get(ShortOptionKey(c));
+					if (entry.tree == static_cast<size_t>(-1)) {
+						entry.tree = treeIndex;
+					}
+					else if (entry.tree != treeIndex) {
+						entry.sharedTree = true;
+					}
+					if (canMatchAlone) {
+						if (ref.arity == 0) {
+							entry.direct = ref;
+						}
+						else {
+							entry.nested = true;
+						}
+					}
+				}
+			}
+
+			std::vector<size_t> OverloadHits () const
+			{
+				std::vector<size_t> hits;
+				for (auto const & registration : registrations) {
+					OverloadRef const & ref = registration.first;
+					hits.push_back(infosByArity[ref.arity][ref.index].hits.load());
+				}
+				return hits;
+			}
+
+			void LoadOverloadProfile (std::vector<size_t> const & hits)
+			{
+				std::vector<size_t> treeHits(overloadTrees.size(), 0);
+				size_t const N = std::min(hits.size(), registrations.size());
+				for (size_t i = 0; i < N; ++i) {
+					treeHits[registrations[i].second] += hits[i];
+				}
+				std::stable_sort(keywordTreeOrder.begin(), keywordTreeOrder.end(), [&] (size_t a, size_t b) {
+					return treeHits[a] > treeHits[b];
+				});
+			}
+
+			template <typename R>
+			OptionError AddImpl (Keyword const & keyword, std::function<R()> const & func)
+			{
+				if (keyword.names.empty()) {
+#ifndef LAMBDA_OPTIONS_NO_THROW
+					throw EmptyOptionException();
+#else
+					return OptionError::EmptyOption;
+#endif
+				}
+				auto wrapper = [=] (OpaqueValues &) {
+					return CallbackResult<Char, R>::Call([&] () { return func(); });
+				};
+				std::vector<ArgKind<Char>> typeKinds;
+				return NewInfo(keyword, typeKinds, wrapper, 0);
+			}
+
+			template <typename R, typename A>
+			OptionError AddImpl (Keyword const & keyword, std::function<R(A)> const & func)
+			{
+				typedef typename SimplifyType<A>::type A2;
+				auto wrapper = [=] (OpaqueValues & vals) {
+					A2 && a = ReifyOpaque<A2>(vals[0]);
+					return CallbackResult<Char, R>::Call([&] () { return func(std::forward<A>(a)); });
+				};
+				std::vector<ArgKind<Char>> typeKinds;
+				PushTypeId<A2>(typeKinds);
+				return NewInfo(keyword, typeKinds, wrapper, 1);
+			}
+
+			template <typename R, typename A, typename B>
+			OptionError AddImpl (Keyword const & keyword, std::function<R(A,B)> const & func)
+			{
+				typedef typename SimplifyType<A>::type A2;
+				typedef typename SimplifyType<B>::type B2;
+				auto wrapper = [=] (OpaqueValues & vals) {
+					A2 && a = ReifyOpaque<A2>(vals[0]);
+					B2 && b = ReifyOpaque<B2>(vals[1]);
+					return CallbackResult<Char, R>::Call([&] () { return func(std::forward<A>(a), std::forward<B>(b)); });
+				};
+				std::vector<ArgKind<Char>> typeKinds;
+				PushTypeId<A2>(typeKinds);
+				PushTypeId<B2>(typeKinds);
+				return NewInfo(keyword, typeKinds, wrapper, 2);
+			}
+
+			template <typename R, typename A, typename B, typename C>
+			OptionError AddImpl (Keyword const & keyword, std::function<R(A,B,C)> const & func)
+			{
+				typedef typename SimplifyType<A>::type A2;
+				typedef typename SimplifyType<B>::type B2;
+				typedef typename SimplifyType<C>::type C2;
+				auto wrapper = [=] (OpaqueValues & vals) {
+					A2 && a = ReifyOpaque<A2>(vals[0]);
+					B2 && b = ReifyOpaque<B2>(vals[1]);
+					C2 && c = ReifyOpaque<C2>(vals[2]);
+					return CallbackResult<Char, R>::Call([&] () { return func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c)); });
+				};
+				std::vector<ArgKind<Char>> typeKinds;
+				PushTypeId<A2>(typeKinds);
+				PushTypeId<B2>(typeKinds);
+				PushTypeId<C2>(typeKinds);
+				return NewInfo(keyword, typeKinds, wrapper, 3);
+			}
+
+			template <typename R, typename A, typename B, typename C, typename D>
+			OptionError AddImpl (Keyword const & keyword, std::function<R(A,B,C,D)> const & func)
+			{
+				typedef typename SimplifyType<A>::type A2;
+				typedef typename SimplifyType<B>::type B2;
+				typedef typename SimplifyType<C>::type C2;
+				typedef typename SimplifyType<D>::type D2;
+				auto wrapper = [=] (OpaqueValues & vals) {
+					A2 && a = ReifyOpaque<A2>(vals[0]);
+					B2 && b = ReifyOpaque<B2>(vals[1]);
+					C2 && c = ReifyOpaque<C2>(vals[2]);
+					D2 && d = ReifyOpaque<D2>(vals[3]);
+					return CallbackResult<Char, R>::Call([&] () { return func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d)); });
+				};
+				std::vector<ArgKind<Char>> typeKinds;
+				PushTypeId<A2>(typeKinds);
+				PushTypeId<B2>(typeKinds);
+				PushTypeId<C2>(typeKinds);
+				PushTypeId<D2>(typeKinds);
+				return NewInfo(keyword, typeKinds, wrapper, 4);
+			}
+
+			template <typename R, typename A, typename B, typename C, typename D, typename E>
+			OptionError AddImpl (Keyword const & keyword, std::function<R(A,B,C,D,E)> const & func)
+			{
+				typedef typename SimplifyType<A>::type A2;
+				typedef typename SimplifyType<B>::type B2;
+				typedef typename SimplifyType<C>::type C2;
+				typedef typename SimplifyType<D>::type D2;
+				typedef typename SimplifyType<E>::type E2;
+				auto wrapper = [=] (OpaqueValues & vals) {
+					A2 && a = ReifyOpaque<A2>(vals[0]);
+					B2 && b = ReifyOpaque<B2>(vals[1]);
+					C2 && c = ReifyOpaque<C2>(vals[2]);
+					D2 && d = ReifyOpaque<D2>(vals[3]);
+					E2 && e = ReifyOpaque<E2>(vals[4]);
+					return CallbackResult<Char, R>::Call([&] () { return func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d), std::forward<E>(e)); });
+				};
+				std::vector<ArgKind<Char>> typeKinds;
+				PushTypeId<A2>(typeKinds);
+				PushTypeId<B2>(typeKinds);
+				PushTypeId<C2>(typeKinds);
+				PushTypeId<D2>(typeKinds);
+				PushTypeId<E2>(typeKinds);
+				return NewInfo(keyword, typeKinds, wrapper, 5);
+			}
+
+			template <typename R, typename A, typename B, typename C, typename D, typename E, typename F>
+			OptionError AddImpl(Keyword const & keyword, std::function<R(A, B, C, D, E, F)> const & func)
+			{
+				typedef typename SimplifyType<A>::type A2;
+				typedef typename SimplifyType<B>::type B2;
+				typedef typename SimplifyType<C>::type C2;
+				typedef typename SimplifyType<D>::type D2;
+				typedef typename SimplifyType<E>::type E2;
+				typedef typename SimplifyType<F>::type F2;
+				auto wrapper = [=](OpaqueValues & vals) {
+					A2 && a = ReifyOpaque<A2>(vals[0]);
+					B2 && b = ReifyOpaque<B2>(vals[1]);
+					C2 && c = ReifyOpaque<C2>(vals[2]);
+					D2 && d = ReifyOpaque<D2>(vals[3]);
+					E2 && e = ReifyOpaque<E2>(vals[4]);
+					F2 && f = ReifyOpaque<F2>(vals[5]);
+					return CallbackResult<Char, R>::Call([&] () { return func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d), std::forward<E>(e), std::forward<F>(f)); });
+				};
+				std::vector<ArgKind<Char>> typeKinds;
+				PushTypeId<A2>(typeKinds);
+				PushTypeId<B2>(typeKinds);
+				PushTypeId<C2>(typeKinds);
+				PushTypeId<D2>(typeKinds);
+				PushTypeId<E2>(typeKinds);
+				PushTypeId<F2>(typeKinds);
+				return NewInfo(keyword, typeKinds, wrapper, 6);
+			}
+
+			template <typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G>
+			OptionError AddImpl(Keyword const & keyword, std::function<R(A, B, C, D, E, F, G)> const & func)
+			{
+				typedef typename SimplifyType<A>::type A2;
+				typedef typename SimplifyType<B>::type B2;
+				typedef typename SimplifyType<C>::type C2;
+				typedef typename SimplifyType<D>::type D2;
+				typedef typename SimplifyType<E>::type E2;
+				typedef typename SimplifyType<F>::type F2;
+				typedef typename SimplifyType<G>::type G2;
+				auto wrapper = [=](OpaqueValues & vals) {
+					A2 && a = ReifyOpaque<A2>(vals[0]);
+					B2 && b = ReifyOpaque<B2>(vals[1]);
+					C2 && c = ReifyOpaque<C2>(vals[2]);
+					D2 && d = ReifyOpaque<D2>(vals[3]);
+					E2 && e = ReifyOpaque<E2>(vals[4]);
+					F2 && f = ReifyOpaque<F2>(vals[5]);
+					G2 && g = ReifyOpaque<G2>(vals[6]);
+					return CallbackResult<Char, R>::Call([&] () { return func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d), std::forward<E>(e), std::forward<F>(f), std::forward<G>(g)); });
+				};
+				std::vector<ArgKind<Char>> typeKinds;
+				PushTypeId<A2>(typeKinds);
+				PushTypeId<B2>(typeKinds);
+				PushTypeId<C2>(typeKinds);
+				PushTypeId<D2>(typeKinds);
+				PushTypeId<E2>(typeKinds);
+				PushTypeId<F2>(typeKinds);
+				PushTypeId<G2>(typeKinds);
+				return NewInfo(keyword, typeKinds, wrapper, 7);
+			}
+
+			template <typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H>
+			OptionError AddImpl(Keyword const & keyword, std::function<R(A, B, C, D, E, F, G, H)> const & func)
+			{
+				typedef typename SimplifyType<A>::type A2;
+				typedef typename SimplifyType<B>::type B2;
+				typedef typename SimplifyType<C>::type C2;
+				typedef typename SimplifyType<D>::type D2;
+				typedef typename SimplifyType<E>::type E2;
+				typedef typename SimplifyType<F>::type F2;
+				typedef typename SimplifyType<G>::type G2;
+				typedef typename SimplifyType<H>::type H2;
+				auto wrapper = [=](OpaqueValues & vals) {
+					A2 && a = ReifyOpaque<A2>(vals[0]);
+					B2 && b = ReifyOpaque<B2>(vals[1]);
+					C2 && c = ReifyOpaque<C2>(vals[2]);
+					D2 && d = ReifyOpaque<D2>(vals[3]);
+					E2 && e = ReifyOpaque<E2>(vals[4]);
+					F2 && f = ReifyOpaque<F2>(vals[5]);
+					G2 && g = ReifyOpaque<G2>(vals[6]);
+					H2 && h = ReifyOpaque<H2>(vals[7]);
+					return CallbackResult<Char, R>::Call([&] () { return func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d), std::forward<E>(e), std::forward<F>(f), std::forward<G>(g), std::forward<H>(h)); });
+				};
+				std::vector<ArgKind<Char>> typeKinds;
+				PushTypeId<A2>(typeKinds);
+				PushTypeId<B2>(typeKinds);
+				PushTypeId<C2>(typeKinds);
+				PushTypeId<D2>(typeKinds);
+				PushTypeId<E2>(typeKinds);
+				PushTypeId<F2>(typeKinds);
+				PushTypeId<G2>(typeKinds);
+				PushTypeId<H2>(typeKinds);
+				return NewInfo(keyword, typeKinds, wrapper, 8);
+			}
+
+			template <typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H, typename I>
+			OptionError AddImpl(Keyword const & keyword, std::function<R(A, B, C, D, E, F, G, H, I)> const & func)
+			{
+				typedef typename SimplifyType<A>::type A2;
+				typedef typename SimplifyType<B>::type B2;
+				typedef typename SimplifyType<C>::type C2;
+				typedef typename SimplifyType<D>::type D2;
+				typedef typename SimplifyType<E>::type E2;
+				typedef typename SimplifyType<F>::type F2;
+				typedef typename SimplifyType<G>::type G2;
+				typedef typename SimplifyType<H>::type H2;
+				typedef typename SimplifyType<I>::type I2;
+				auto wrapper = [=](OpaqueValues & vals) {
+					A2 && a = ReifyOpaque<A2>(vals[0]);
+					B2 && b = ReifyOpaque<B2>(vals[1]);
+					C2 && c = ReifyOpaque<C2>(vals[2]);
+					D2 && d = ReifyOpaque<D2>(vals[3]);
+					E2 && e = ReifyOpaque<E2>(vals[4]);
+					F2 && f = ReifyOpaque<F2>(vals[5]);
+					G2 && g = ReifyOpaque<G2>(vals[6]);
+					H2 && h = ReifyOpaque<H2>(vals[7]);
+					I2 && i = ReifyOpaque<I2>(vals[8]);
+					return CallbackResult<Char, R>::Call([&] () { return func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d), std::forward<E>(e), std::forward<F>(f), std::forward<G>(g), std::forward<H>(h), std::forward<I>(i)); });
+				};
+				std::vector<ArgKind<Char>> typeKinds;
+				PushTypeId<A2>(typeKinds);
+				PushTypeId<B2>(typeKinds);
+				PushTypeId<C2>(typeKinds);
+				PushTypeId<D2>(typeKinds);
+				PushTypeId<E2>(typeKinds);
+				PushTypeId<F2>(typeKinds);
+				PushTypeId<G2>(typeKinds);
+				PushTypeId<H2>(typeKinds);
+				PushTypeId<I2>(typeKinds);
+				return NewInfo(keyword, typeKinds, wrapper, 9);
+			}
+
+			template <typename R, typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H, typename I, typename J>
+			OptionError AddImpl(Keyword const & keyword, std::function<R(A, B, C, D, E, F, G, H, I, J)> const & func)
+			{
+				typedef typename SimplifyType<A>::type A2;
+				typedef typename SimplifyType<B>::type B2;
+				typedef typename SimplifyType<C>::type C2;
 				typedef typename SimplifyType<D>::type D2;
 				typedef typename SimplifyType<E>::type E2;
-				auto wrapper = [=] (OpaqueValues & vals) {
+				typedef typename SimplifyType<F>::type F2;
+				typedef typename SimplifyType<G>::type G2;
+				typedef typename SimplifyType<H>::type H2;
+				typedef typename SimplifyType<I>::type I2;
+				typedef typename SimplifyType<J>::type J2;
+				auto wrapper = [=](OpaqueValues & vals) {
 					A2 && a = ReifyOpaque<A2>(vals[0]);
 					B2 && b = ReifyOpaque<B2>(vals[1]);
 					C2 && c = ReifyOpaque<C2>(vals[2]);
 					D2 && d = ReifyOpaque<D2>(vals[3]);
 					E2 && e = ReifyOpaque<E2>(vals[4]);
-					func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d), std::forward<E>(e));
+					F2 && f = ReifyOpaque<F2>(vals[5]);
+					G2 && g = ReifyOpaque<G2>(vals[6]);
+					H2 && h = ReifyOpaque<H2>(vals[7]);
+					I2 && i = ReifyOpaque<I2>(vals[8]);
+					J2 && j = ReifyOpaque<J2>(vals[9]);
+					return CallbackResult<Char, R>::Call([&] () { return func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d), std::forward<E>(e), std::forward<F>(f), std::forward<G>(g), std::forward<H>(h), std::forward<I>(i), std::forward<J>(j)); });
 				};
-				std::vector<TypeId> typeKinds;
+				std::vector<ArgKind<Char>> typeKinds;
 				PushTypeId<A2>(typeKinds);
 				PushTypeId<B2>(typeKinds);
 				PushTypeId<C2>(typeKinds);
 				PushTypeId<D2>(typeKinds);
 				PushTypeId<E2>(typeKinds);
-				NewInfo(keyword, typeKinds, wrapper, 5);
+				PushTypeId<F2>(typeKinds);
+				PushTypeId<G2>(typeKinds);
+				PushTypeId<H2>(typeKinds);
+				PushTypeId<I2>(typeKinds);
+				PushTypeId<J2>(typeKinds);
+				return NewInfo(keyword, typeKinds, wrapper, 10);
+			}
+
+
+			template <typename T, typename Func>
+			OptionError AddOption (Keyword const & keyword, Span<T> destination, Func const & f)
+			{
+				Keyword kw = MassageKeyword(keyword);
+				return AddIntoImpl<T, typename FuncTraits<Func>::Return::type>(kw, destination, f);
+			}
+
+			template <typename T, typename R>
+			OptionError AddIntoImpl (Keyword const & keyword, Span<T> const & destination, std::function<R(Span<T>)> const & func)
+			{
+				auto wrapper = [=] (OpaqueValues & vals) {
+					return CallbackResult<Char, R>::Call([&] () { return func(CommitSpan<T>(vals[0])); });
+				};
+				std::vector<ArgKind<Char>> typeKinds;
+				typeKinds.push_back(ArgKind<Char>::template Of<Span<T>>(ParseIntoSpan<Char, T>, std::make_shared<Span<T>>(destination)));
+				return NewInfo(keyword, typeKinds, wrapper, 1);
+			}
+
+
+			template <typename Func>
+			OptionError AddCollectedOption (Keyword const & keyword, Func const & f)
+			{
+				static_assert(FuncTraits<Func>::arity == 1, "A collected option's function takes a single std::vector.");
+				typedef typename FuncTraits<Func>::Arg0::type Arg;
+				typedef typename SimplifyType<Arg>::type Values;
+				Keyword kw = MassageKeyword(keyword);
+				return AddCollectedImpl<typename Values::value_type, typename FuncTraits<Func>::Return::type, Arg>(kw, f);
+			}
+
+			// The batch is passed as the function declares it, so a reference keeps its storage for the next run.
+			template <typename T, typename R, typename Arg>
+			OptionError AddCollectedImpl (Keyword const & keyword, std::function<R(Arg)> const & func)
+			{
+				if (keyword.negatable || keyword.counted) {
+#ifndef LAMBDA_OPTIONS_NO_THROW
+					throw CollectedKeywordException();
+#else
+					return OptionError::CollectedKeyword;
+#endif
+				}
+				auto wrapper = [=] (OpaqueValues & vals) {
+					std::vector<T> & batch = *static_cast<std::vector<T> *>(vals[0].get());
+					return CallbackResult<Char, R>::Call([&] () { return func(std::forward<Arg>(batch)); });
+				};
+				std::vector<ArgKind<Char>> typeKinds;
+				PushTypeId<T>(typeKinds);
+				OverloadRef ref(0, 0);
+				OptionError const error = NewInfo(keyword, typeKinds, wrapper, 1, ref);
+				if (error == OptionError::None) {
+					infosByArity[ref.arity][ref.index].batchSlot = collectedOptions.size();
+					collectedOptions.emplace_back(ref, Batch<T>::Ops());
+				}
+				return error;
+			}
+
+
+			template <typename Func>
+			OptionError AddRestHandler (Func const & f)
+			{
+				return AddBatchHandler<typename FuncTraits<Func>::Return::type>(restHandler, "rest handler", f);
+			}
+
+			template <typename Func>
+			OptionError AddPositionalBatch (Func const & f)
+			{
+				return AddBatchHandler<typename FuncTraits<Func>::Return::type>(positionalBatch, "positional batch", f);
+			}
+
+			template <typename R>
+			OptionError AddBatchHandler (BatchHandler & handler, char const * handlerName, std::function<R(Span<String const>)> const & func)
+			{
+				if (handler) {
+#ifndef LAMBDA_OPTIONS_NO_THROW
+					throw HandlerConflictException(handlerName);
+#else
+					(void) handlerName;
+					return OptionError::HandlerConflict;
+#endif
+				}
+				handler = [=] (Span<String const> const & args) {
+					return CallbackResult<Char, R>::Call([&] () { return func(args); });
+				};
+				return OptionError::None;
+			}
+
+
+			template <typename T>
+			void PushTypeId (std::vector<ArgKind<Char>> & kinds)
+			{
+				kinds.push_back(ArgKind<Char>::template Of<T>(OpaqueParse<Char, T>));
+			}
+
+
+		public:
+			std::vector<std::pair<String, Priority>> helpGroupPriorities;
+			OptionsConfig config;
+			std::vector<std::vector<OptInfo<Char>>> infosByArity;
+			std::vector<OverloadTree<Char>> overloadTrees;
+			std::vector<size_t> keywordTreeOrder;                        // the order keywords are looked up in
+			size_t keywordlessTree;                                      // -1 if there is none
+			std::vector<std::pair<OverloadRef, size_t>> registrations;   // each overload and its tree, in registration order
+			SuggestionIndex<Char> suggestionIndex;                       // every keyword name
+			ShortOptionTable<Char> shortOptions;                         // keyed by ShortOptionKey
+			PrefixTrie<Char> joinedPrefixes;                             // every keyword prefix
+			std::vector<std::pair<OverloadRef, CountOpaque>> countedFlags; // each counted overload and how to pass its count
+			std::vector<std::pair<OverloadRef, BatchOps>> collectedOptions; // each collected overload and how to batch its values
+			LeadCharacters<Char> leadCharacters;                         // of every keyword name and prefix
+			BatchHandler positionalBatch;                                // empty if there is none
+			BatchHandler restHandler;                                    // empty if there is none
+		};
+
+
+		template <typename Char>
+		class ParseContextImpl {
+			friend class ArgsIter<Char>;
+
+			typedef LAMBDA_OPTIONS_NAMESPACE::_private::OptionsImpl<Char> OptionsImpl;
+			typedef std::basic_string<Char> String;
+			typedef typename String::const_iterator StringIter;
+
+		private:
+			ParseContextImpl (ParseContextImpl const &); // disable
+			void operator= (ParseContextImpl const &);   // disable
+
+		public:
+			ParseContextImpl (std::shared_ptr<OptionsImpl const> opts, std::vector<String> && args, void * userData)
+				: opts(opts)
+				, sharedArgs(std::make_shared<std::vector<String>>(std::move(args)))
+				, args(*sharedArgs)
+				, begin(this->args.begin(), this->args.end(), this)
+				, end(this->args.end(), this->args.end(), this)
+				, iter(begin)
+				, parseState(iter, end, userData)
+				, iterHighMark(0)
+				, rejectMessageWithHighMark(String(), static_cast<size_t>(-1))
+				, keywordTreeOrder(opts->keywordTreeOrder)
+				, steps(0)
+				, aborted(false)
+				, abortReason(ParseFailure::BadArguments)
+				, suppressCallbacks(false)
+				, flagCounts(opts->countedFlags.size(), 0)
+				, flagIndices(opts->countedFlags.size(), 0)
+				, batchIndices(opts->collectedOptions.size(), 0)
+				, optionIndex(0)
+				, soleOverload(false)
+				, negatedMatch(false)
+				, optionsEnded(false)
+				, userData(userData)
+			{
+				for (auto const & collected : opts->collectedOptions) {
+					batches.push_back(collected.second.create());
+				}
+			}
+
+			std::vector<String> const & Args () const
+			{
+				return args;
+			}
+
+			bool Run (ParseFailedException<Char> & e)
+			{
+				BeginRun();
+				bool const success = ParseRest() && DeliverTotals();
+				if (success) {
+					return true;
+				}
+				e = Failure();
+				return false;
+			}
+
+			// Records each failure, then skips to the next keyword and carries on without running callbacks.
+			bool Run (std::vector<ParseFailedException<Char>> & errors)
+			{
+				size_t const errorCount = errors.size();
+				BeginRun();
+				while (!ParseRest()) {
+					errors.push_back(Failure());
+					if (aborted) {
+						break;
+					}
+					suppressCallbacks = true;
+					do {
+						++iter.iter;
+					} while (iter != end && !optionsEnded && !IsKeyword(*iter));
+					iterHighMark = IterIndex();
+					rejectMessageWithHighMark = std::make_pair(String(), static_cast<size_t>(-1));
+				}
+				if (!DeliverTotals()) {
+					errors.push_back(Failure());
+				}
+				return errors.size() == errorCount;
+			}
+
+			// Parses from iter until the arguments run out or no option matches. Returns true if they ran out.
+			bool ParseRest ()
+			{
+				while (TryParse()) {
+					continue;
+				}
+				return !aborted && iter == end;
+			}
+
+			void BeginRun ()
+			{
+				iter = begin;
+				optionsEnded = false;
+				steps = 0;
+				aborted = false;
+				abortReason = ParseFailure::BadArguments;
+				suppressCallbacks = false;
+				iterHighMark = 0;
+				rejectMessageWithHighMark = std::make_pair(String(), static_cast<size_t>(-1));
+				std::fill(flagCounts.begin(), flagCounts.end(), 0);
+				for (size_t slot = 0; slot < batches.size(); ++slot) {
+					opts->collectedOptions[slot].second.clear(batches[slot].get());
+				}
+			}
+
+			// Runs the function of each counted option given with its count, then that of each collected option given
+			// with its batch of values, once each. A function that rejects fails the parse at the option's first
+			// occurrence, and the remaining functions do not run.
+			bool DeliverTotals ()
+			{
+				if (suppressCallbacks || aborted) {
+					return true;
+				}
+				for (size_t slot = 0; slot < flagCounts.size(); ++slot) {
+					if (flagCounts[slot] == 0) {
+						continue;
+					}
+					auto const & counted = opts->countedFlags[slot];
+					OpaqueValues values;
+					values.push_back(counted.second(flagCounts[slot]));
+					if (!DeliverTotal(counted.first, values, flagIndices[slot])) {
+						return false;
+					}
+				}
+				for (size_t slot = 0; slot < batches.size(); ++slot) {
+					auto const & collected = opts->collectedOptions[slot];
+					if (collected.second.empty(batches[slot].get())) {
+						continue;
+					}
+					OpaqueValues values;
+					values.emplace_back(batches[slot].get(), [] (void *) {});
+					if (!DeliverTotal(collected.first, values, batchIndices[slot])) {
+						return false;
+					}
+					collected.second.clear(batches[slot].get());
+				}
+				return true;
+			}
+
+			// A total stands for every occurrence rather than any argument, so a rejection is reported at the option's
+			// own argument at optionIndex.
+			bool DeliverTotal (OverloadRef const & ref, OpaqueValues & values, size_t optionIndex)
+			{
+#ifndef LAMBDA_OPTIONS_NO_THROW
+				try {
+#endif
+					Verdict<Char> const verdict = opts->infosByArity[ref.arity][ref.index].callback(values);
+					if (verdict.accepted) {
+						return true;
+					}
+					Reject(optionIndex, verdict.message);
+#ifndef LAMBDA_OPTIONS_NO_THROW
+				}
+				catch (RejectArgumentException<Char> const & e) {
+					Reject(optionIndex, e.message);
+				}
+#endif
+				iter = IterAt(optionIndex);
+				return false;
+			}
+
+			// Describes why parsing stopped at iter.
+			ParseFailedException<Char> Failure () const
+			{
+				size_t const currArgIndex = IterIndex();
+				if (aborted) {
+					return ParseFailedException<Char>(currArgIndex, iterHighMark + 1, abortReason);
+				}
+				if (rejectMessageWithHighMark.second == iterHighMark) {
+					return ParseFailedException<Char>(currArgIndex, iterHighMark + 1, sharedArgs, rejectMessageWithHighMark.first);
+				}
+				ParseFailedException<Char> e(currArgIndex, iterHighMark + 1, sharedArgs);
+				if (iterHighMark == currArgIndex) {
+					e.suggestions = opts->suggestionIndex.Suggest(args[currArgIndex], opts->config.suggestionDistance, opts->config.maxSuggestions);
+				}
+				return e;
+			}
+
+			// Counts one step of work. Returns false once a limit has been reached.
+			bool Step ()
+			{
+				if (aborted) {
+					return false;
+				}
+				if (++steps > limits.maxSteps) {
+					aborted = true;
+					abortReason = ParseFailure::WorkLimitExceeded;
+				}
+				else if (limits.cancel != nullptr && limits.cancel->load(std::memory_order_relaxed)) {
+					aborted = true;
+					abortReason = ParseFailure::Cancelled;
+				}
+				return !aborted;
+			}
+
+			static bool Step (ParseState<Char> & parseState)
+			{
+				auto & parseContext = *static_cast<ParseContextImpl *>(parseState.iter.opaqueParseContext);
+				return parseContext.Step();
+			}
+
+			static void * Opaque (ParseState<Char> & parseState)
+			{
+				return parseState.iter.opaqueParseContext;
+			}
+
+			ArgsIter<Char> IterAt (size_t index, String const * attached = nullptr) const
+			{
+				ArgsIter<Char> it = begin;
+				it.iter += static_cast<std::ptrdiff_t>(index);
+				it.attached = attached;
+				return it;
+			}
+
+			// Copies an attached value that a Lazy<T> may convert after attachedValue has been reused.
+			static String const * PinAttached (ArgsIter<Char> const & it)
+			{
+				if (it.attached == nullptr) {
+					return nullptr;
+				}
+				auto & parseContext = *static_cast<ParseContextImpl<Char> *>(it.opaqueParseContext);
+				parseContext.pinnedValues.emplace_back(new String(*it.attached));
+				return parseContext.pinnedValues.back().get();
+			}
+
+			static size_t & IterHighMark (ParseState<Char> & parseState)
+			{
+				auto & parseContext = *static_cast<ParseContextImpl *>(parseState.iter.opaqueParseContext);
+				return parseContext.iterHighMark;
+			}
+
+			// True while the overload being parsed is the only one its argument can match, so the overload wins
+			// unless its parse fails or its function rejects.
+			static bool SoleOverload (ParseState<Char> & parseState)
+			{
+				auto & parseContext = *static_cast<ParseContextImpl *>(parseState.iter.opaqueParseContext);
+				return parseContext.soleOverload;
+			}
+
+			// The scratch of the output span option bound to binding, created on its first occurrence.
+			template <typename T>
+			static SpanScratch<T> & ScratchFor (ParseState<Char> & parseState, void const * binding)
+			{
+				auto & parseContext = *static_cast<ParseContextImpl *>(parseState.iter.opaqueParseContext);
+				for (auto const & entry : parseContext.spanScratches) {
+					if (entry.first == binding) {
+						return *static_cast<SpanScratch<T> *>(entry.second.get());
+					}
+				}
+				parseContext.spanScratches.emplace_back(binding, UniqueOpaque(new SpanScratch<T>(), Delete<SpanScratch<T>>));
+				return *static_cast<SpanScratch<T> *>(parseContext.spanScratches.back().second.get());
+			}
+
+#ifdef LAMBDA_OPTIONS_FILE_MAPPING
+			static MappedFile const * MapFile (ParseState<Char> & parseState, String const & path)
+			{
+				auto & parseContext = *static_cast<ParseContextImpl *>(parseState.iter.opaqueParseContext);
+				auto * pFile = _private::Lookup(parseContext.mappedFiles, path);
+				if (pFile == nullptr) {
+					std::unique_ptr<MappedFile> file(new MappedFile());
+					if (!file->Open(path)) {
+						file.reset();
+					}
+					parseContext.mappedFiles.emplace_back(path, std::move(file));
+					pFile = &parseContext.mappedFiles.back().second;
+				}
+				return pFile->get();
+			}
+#endif
+
+		private:
+			size_t IterIndex () const
+			{
+				return static_cast<size_t>(iter.iter - begin.iter);
+			}
+
+			ParseMemo * FindParseMemo (size_t argIndex, TypeId const & typeId)
+			{
+				for (ParseMemo & memo : parseMemos) {
+					if (memo.argIndex == argIndex && memo.typeId == typeId) {
+						return &memo;
+					}
+				}
+				return nullptr;
+			}
+
+			// Parses one argument, reusing the result of an earlier overload that parsed the same type at the same index.
+			// Failures are remembered immediately. Successes are remembered only once ForgetParsedArgs hands their values back.
+			UniqueOpaque ParseArg (ArgKind<Char> const & typeKind, std::vector<ParseMemo> & parsedSpans)
+			{
+				if (!typeKind.CanStartWith(iter == end ? nullptr : &*iter)) {
+					return UniqueOpaque(nullptr, Delete<Any>);
+				}
+				size_t const argIndex = IterIndex();
+				ParseMemo * memo = nullptr;
+				if (typeKind.binding == nullptr) {
+					memo = FindParseMemo(argIndex, typeKind.typeId);
+					if (memo != nullptr && (memo->Failed() || memo->value != nullptr)) {
+						iterHighMark = std::max(iterHighMark, memo->highMark);
+						if (memo->Failed()) {
+							return UniqueOpaque(nullptr, memo->value.get_deleter());
+						}
+						if (memo->endIndex != argIndex) {
+							iter.iter = begin.iter + static_cast<std::ptrdiff_t>(memo->endIndex);
+							iter.attached = nullptr;
+						}
+						parsedSpans.emplace_back(argIndex, typeKind.typeId, memo->endIndex, memo->highMark, UniqueOpaque(nullptr, memo->value.get_deleter()));
+						return std::move(memo->value);
+					}
+				}
+
+				size_t const prevHighMark = iterHighMark;
+				iterHighMark = 0;
+				UniqueOpaque parsedArg = typeKind.Parse(parseState);
+				size_t const highMark = iterHighMark;
+				iterHighMark = std::max(prevHighMark, highMark);
+
+				if (parsedArg != nullptr) {
+					parsedSpans.emplace_back(argIndex, typeKind.typeId, IterIndex(), highMark, UniqueOpaque(nullptr, parsedArg.get_deleter()));
+				}
+				else if (typeKind.binding == nullptr) {
+					parseMemos.emplace_back(argIndex, typeKind.typeId, static_cast<size_t>(-1), highMark, UniqueOpaque(nullptr, parsedArg.get_deleter()));
+				}
+				return parsedArg;
+			}
+
+			OpaqueValues ParseArgs (std::vector<ArgKind<Char>> const & typeKinds, std::vector<ParseMemo> & parsedSpans)
+			{
+				size_t const N = typeKinds.size();
+				OpaqueValues parsedArgs;
+				for (size_t i = 0; i < N; ++i) {
+					ArgKind<Char> const & typeKind = typeKinds[i];
+					UniqueOpaque parsedArg = ParseArg(typeKind, parsedSpans);
+					if (parsedArg == nullptr) {
+						break;
+					}
+					parsedArgs.emplace_back(std::move(parsedArg));
+				}
+				return parsedArgs;
+			}
+
+			// Returns the values of an overload that did not match to the memo so later overloads can reuse them.
+			// Bound arguments write through to caller storage, so they are always parsed afresh.
+			void ForgetParsedArg (ArgKind<Char> const & typeKind, UniqueOpaque & parsedArg, ParseMemo & parsedSpan)
+			{
+				if (typeKind.binding != nullptr) {
+					return;
+				}
+				parsedSpan.value = std::move(parsedArg);
+				ParseMemo * memo = FindParseMemo(parsedSpan.argIndex, parsedSpan.typeId);
+				if (memo == nullptr) {
+					parseMemos.emplace_back(std::move(parsedSpan));
+				}
+				else {
+					memo->value = std::move(parsedSpan.value);
+				}
+			}
+
+			void ForgetParsedArgs (std::vector<ArgKind<Char>> const & typeKinds, OpaqueValues & parsedArgs, std::vector<ParseMemo> & parsedSpans)
+			{
+				for (size_t i = 0; i < parsedArgs.size(); ++i) {
+					ForgetParsedArg(typeKinds[i], parsedArgs[i], parsedSpans[i]);
+				}
 			}
 
-			template <typename A, typename B, typename C, typename D, typename E, typename F>
-			void AddImpl(Keyword const & keyword, std::function<void(A, B, C, D, E, F)> const & func)
+			bool MatchesAny (std::vector<String> const & names, String const & arg) const
 			{
-				typedef typename SimplifyType<A>::type A2;
-				typedef typename SimplifyType<B>::type B2;
-				typedef typename SimplifyType<C>::type C2;
-				typedef typename SimplifyType<D>::type D2;
-				typedef typename SimplifyType<E>::type E2;
-				typedef typename SimplifyType<F>::type F2;
-				auto wrapper = [=](OpaqueValues & vals) {
-					A2 && a = ReifyOpaque<A2>(vals[0]);
-					B2 && b = ReifyOpaque<B2>(vals[1]);
-					C2 && c = ReifyOpaque<C2>(vals[2]);
-					D2 && d = ReifyOpaque<D2>(vals[3]);
-					E2 && e = ReifyOpaque<E2>(vals[4]);
-					F2 && f = ReifyOpaque<F2>(vals[5]);
-					func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d), std::forward<E>(e), std::forward<F>(f));
-				};
-				std::vector<TypeId> typeKinds;
-				PushTypeId<A2>(typeKinds);
-				PushTypeId<B2>(typeKinds);
-				PushTypeId<C2>(typeKinds);
-				PushTypeId<D2>(typeKinds);
-				PushTypeId<E2>(typeKinds);
-				PushTypeId<F2>(typeKinds);
-				NewInfo(keyword, typeKinds, wrapper, 6);
+				for (String const & name : names) {
+					if (MatchesName(opts->config.matchFlags, arg, name)) {
+						return true;
+					}
+				}
+				return false;
 			}
 
-			template <typename A, typename B, typename C, typename D, typename E, typename F, typename G>
-			void AddImpl(Keyword const & keyword, std::function<void(A, B, C, D, E, F, G)> const & func)
+			bool MatchesKeyword (Keyword<Char> const & keyword, String const & arg) const
 			{
-				typedef typename SimplifyType<A>::type A2;
-				typedef typename SimplifyType<B>::type B2;
-				typedef typename SimplifyType<C>::type C2;
-				typedef typename SimplifyType<D>::type D2;
-				typedef typename SimplifyType<E>::type E2;
-				typedef typename SimplifyType<F>::type F2;
-				typedef typename SimplifyType<G>::type G2;
-				auto wrapper = [=](OpaqueValues & vals) {
-					A2 && a = ReifyOpaque<A2>(vals[0]);
-					B2 && b = ReifyOpaque<B2>(vals[1]);
-					C2 && c = ReifyOpaque<C2>(vals[2]);
-					D2 && d = ReifyOpaque<D2>(vals[3]);
-					E2 && e = ReifyOpaque<E2>(vals[4]);
-					F2 && f = ReifyOpaque<F2>(vals[5]);
-					G2 && g = ReifyOpaque<G2>(vals[6]);
-					func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d), std::forward<E>(e), std::forward<F>(f), std::forward<G>(g));
-				};
-				std::vector<TypeId> typeKinds;
-				PushTypeId<A2>(typeKinds);
-				PushTypeId<B2>(typeKinds);
-				PushTypeId<C2>(typeKinds);
-				PushTypeId<D2>(typeKinds);
-				PushTypeId<E2>(typeKinds);
-				PushTypeId<F2>(typeKinds);
-				PushTypeId<G2>(typeKinds);
-				NewInfo(keyword, typeKinds, wrapper, 7);
+				return MatchesKeyword(keyword, arg.begin(), arg.end());
 			}
 
-			template <typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H>
-			void AddImpl(Keyword const & keyword, std::function<void(A, B, C, D, E, F, G, H)> const & func)
+			template <typename ArgIter>
+			bool MatchesKeyword (Keyword<Char> const & keyword, ArgIter argBegin, ArgIter argEnd) const
 			{
-				typedef typename SimplifyType<A>::type A2;
-				typedef typename SimplifyType<B>::type B2;
-				typedef typename SimplifyType<C>::type C2;
-				typedef typename SimplifyType<D>::type D2;
-				typedef typename SimplifyType<E>::type E2;
-				typedef typename SimplifyType<F>::type F2;
-				typedef typename SimplifyType<G>::type G2;
-				typedef typename SimplifyType<H>::type H2;
-				auto wrapper = [=](OpaqueValues & vals) {
-					A2 && a = ReifyOpaque<A2>(vals[0]);
-					B2 && b = ReifyOpaque<B2>(vals[1]);
-					C2 && c = ReifyOpaque<C2>(vals[2]);
-					D2 && d = ReifyOpaque<D2>(vals[3]);
-					E2 && e = ReifyOpaque<E2>(vals[4]);
-					F2 && f = ReifyOpaque<F2>(vals[5]);
-					G2 && g = ReifyOpaque<G2>(vals[6]);
-					H2 && h = ReifyOpaque<H2>(vals[7]);
-					func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d), std::forward<E>(e), std::forward<F>(f), std::forward<G>(g), std::forward<H>(h));
-				};
-				std::vector<TypeId> typeKinds;
-				PushTypeId<A2>(typeKinds);
-				PushTypeId<B2>(typeKinds);
-				PushTypeId<C2>(typeKinds);
-				PushTypeId<D2>(typeKinds);
-				PushTypeId<E2>(typeKinds);
-				PushTypeId<F2>(typeKinds);
-				PushTypeId<G2>(typeKinds);
-				PushTypeId<H2>(typeKinds);
-				NewInfo(keyword, typeKinds, wrapper, 8);
+				for (String const & name : keyword.names) {
+					if (MatchesName(opts->config.matchFlags, argBegin, argEnd, name)) {
+						return true;
+					}
+				}
+				return false;
 			}
 
-			template <typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H, typename I>
-			void AddImpl(Keyword const & keyword, std::function<void(A, B, C, D, E, F, G, H, I)> const & func)
+			bool MatchKeyword (Keyword<Char> const & keyword)
 			{
-				typedef typename SimplifyType<A>::type A2;
-				typedef typename SimplifyType<B>::type B2;
-				typedef typename SimplifyType<C>::type C2;
-				typedef typename SimplifyType<D>::type D2;
-				typedef typename SimplifyType<E>::type E2;
-				typedef typename SimplifyType<F>::type F2;
-				typedef typename SimplifyType<G>::type G2;
-				typedef typename SimplifyType<H>::type H2;
-				typedef typename SimplifyType<I>::type I2;
-				auto wrapper = [=](OpaqueValues & vals) {
-					A2 && a = ReifyOpaque<A2>(vals[0]);
-					B2 && b = ReifyOpaque<B2>(vals[1]);
-					C2 && c = ReifyOpaque<C2>(vals[2]);
-					D2 && d = ReifyOpaque<D2>(vals[3]);
-					E2 && e = ReifyOpaque<E2>(vals[4]);
-					F2 && f = ReifyOpaque<F2>(vals[5]);
-					G2 && g = ReifyOpaque<G2>(vals[6]);
-					H2 && h = ReifyOpaque<H2>(vals[7]);
-					I2 && i = ReifyOpaque<I2>(vals[8]);
-					func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d), std::forward<E>(e), std::forward<F>(f), std::forward<G>(g), std::forward<H>(h), std::forward<I>(i));
-				};
-				std::vector<TypeId> typeKinds;
-				PushTypeId<A2>(typeKinds);
-				PushTypeId<B2>(typeKinds);
-				PushTypeId<C2>(typeKinds);
-				PushTypeId<D2>(typeKinds);
-				PushTypeId<E2>(typeKinds);
-				PushTypeId<F2>(typeKinds);
-				PushTypeId<G2>(typeKinds);
-				PushTypeId<H2>(typeKinds);
-				PushTypeId<I2>(typeKinds);
-				NewInfo(keyword, typeKinds, wrapper, 9);
+				negatedMatch = false;
+				if (keyword.names.empty()) {
+					return true;
+				}
+				if (MatchesKeyword(keyword, *iter)) {
+					negatedMatch = keyword.negatable && MatchesAny(keyword.negatedNames, *iter);
+					++iter;
+					return true;
+				}
+				return false;
 			}
 
-			template <typename A, typename B, typename C, typename D, typename E, typename F, typename G, typename H, typename I, typename J>
-			void AddImpl(Keyword const & keyword, std::function<void(A, B, C, D, E, F, G, H, I, J)> const & func)
+			bool IsKeyword (String const & str) const
 			{
-				typedef typename SimplifyType<A>::type A2;
-				typedef typename SimplifyType<B>::type B2;
-				typedef typename SimplifyType<C>::type C2;
-				typedef typename SimplifyType<D>::type D2;
-				typedef typename SimplifyType<E>::type E2;
-				typedef typename SimplifyType<F>::type F2;
-				typedef typename SimplifyType<G>::type G2;
-				typedef typename SimplifyType<H>::type H2;
-				typedef typename SimplifyType<I>::type I2;
-				typedef typename SimplifyType<J>::type J2;
-				auto wrapper = [=](OpaqueValues & vals) {
-					A2 && a = ReifyOpaque<A2>(vals[0]);
-					B2 && b = ReifyOpaque<B2>(vals[1]);
-					C2 && c = ReifyOpaque<C2>(vals[2]);
-					D2 && d = ReifyOpaque<D2>(vals[3]);
-					E2 && e = ReifyOpaque<E2>(vals[4]);
-					F2 && f = ReifyOpaque<F2>(vals[5]);
-					G2 && g = ReifyOpaque<G2>(vals[6]);
-					H2 && h = ReifyOpaque<H2>(vals[7]);
-					I2 && i = ReifyOpaque<I2>(vals[8]);
-					J2 && j = ReifyOpaque<J2>(vals[9]);
-					func(std::forward<A>(a), std::forward<B>(b), std::forward<C>(c), std::forward<D>(d), std::forward<E>(e), std::forward<F>(f), std::forward<G>(g), std::forward<H>(h), std::forward<I>(i), std::forward<J>(j));
-				};
-				std::vector<TypeId> typeKinds;
-				PushTypeId<A2>(typeKinds);
-				PushTypeId<B2>(typeKinds);
-				PushTypeId<C2>(typeKinds);
-				PushTypeId<D2>(typeKinds);
-				PushTypeId<E2>(typeKinds);
-				PushTypeId<F2>(typeKinds);
-				PushTypeId<G2>(typeKinds);
-				PushTypeId<H2>(typeKinds);
-				PushTypeId<I2>(typeKinds);
-				PushTypeId<J2>(typeKinds);
-				NewInfo(keyword, typeKinds, wrapper, 10);
+				if (!opts->leadCharacters.MayStart(str)) {
+					return false;
+				}
+				typename PrefixTrie<Char>::Node const * node;
+				if (opts->joinedPrefixes.Longest(str, str.size(), node) != 0) {
+					return true;
+				}
+				bool ambiguous;
+				return FindKeywordTree(str.begin(), str.end(), ambiguous) != static_cast<size_t>(-1);
+			}
+
+			// Sets grouped once the argument is known to be a group of short keywords, whether or not they then parse.
+			bool MatchGnuShortGrouping (bool & grouped)
+			{
+				grouped = false;
+
+				if ((opts->config.matchFlags & MatchFlags::GnuShortGrouping) == MatchFlags::Empty) {
+					return false;
+				}
+
+				String const & groupedArgs = *iter;
+				if (groupedArgs.size() < 3 || groupedArgs[0] != '-' || groupedArgs[1] == '-') {
+					return false;
+				}
+
+				// Characters that can match without arguments are flags. The first one that cannot takes the rest of
+				// the group as its first value, or the arguments that follow the group if it ends the group.
+				size_t valueAt = groupedArgs.size();
+				for (size_t i = 1; i < groupedArgs.size(); ++i) {
+					auto const * entry = opts->shortOptions.Find(opts->ShortOptionKey(groupedArgs[i]));
+					if (entry == nullptr) {
+						return false;
+					}
+					if (!entry->Alone()) {
+						if (entry->sharedTree) {
+							return false;
+						}
+						valueAt = i;
+						break;
+					}
+				}
+				grouped = true;
+
+				// A flag whose keyword has only a zero-arity overload runs it in place. Anything else could also match an
+				// overload with arguments, so it is parsed as a lone "-c" argument. So is a flag whose overload rejects,
+				// since a keyword-less option or the positional batch may still take "-c"; its keyword is not retried.
+				for (size_t i = 1; i < valueAt; ++i) {
+					auto const & entry = *opts->shortOptions.Find(opts->ShortOptionKey(groupedArgs[i]));
+					bool const direct = !entry.nested && entry.direct.index != static_cast<size_t>(-1);
+					if (direct) {
+						negatedMatch = false;
+						if (!Step()) {
+							return false;
+						}
+						if (TryOverload(opts->infosByArity[0][entry.direct.index])) {
+							continue;
+						}
+						if (aborted) {
+							return false;
+						}
+					}
+					String artificialArg(2, '-');
+					artificialArg[1] = groupedArgs[i];
+					ParseContextImpl<Char> parseContext(opts, std::vector<String>(1, artificialArg), userData);
+					if (direct) {
+						parseContext.keywordTreeOrder.clear();
+					}
+					parseContext.limits = limits;
+					parseContext.steps = steps;
+					parseContext.suppressCallbacks = suppressCallbacks;
+					parseContext.iter = parseContext.begin;
+					bool const success = parseContext.ParseRest();
+					steps = parseContext.steps;
+					for (size_t slot = 0; slot < flagCounts.size(); ++slot) {
+						if (flagCounts[slot] == 0) {
+							flagIndices[slot] = optionIndex;
+						}
+						flagCounts[slot] += parseContext.flagCounts[slot];
+					}
+					for (size_t slot = 0; slot < batches.size(); ++slot) {
+						auto const & collected = opts->collectedOptions[slot];
+						if (collected.second.empty(batches[slot].get())) {
+							batchIndices[slot] = optionIndex;
+						}
+						collected.second.appendAll(batches[slot].get(), parseContext.batches[slot].get());
+					}
+					if (parseContext.aborted) {
+						aborted = true;
+						abortReason = parseContext.abortReason;
+					}
+					if (!success) {
+						return false;
+					}
+				}
+
+				if (valueAt == groupedArgs.size()) {
+					++iter;
+					return true;
+				}
+				return MatchGroupedValues(valueAt);
+			}
+
+			// Parses the arguments of the short option at valueAt within the group at iter. A value glued to it is seen
+			// by the overloads in place of the group, and overloads that leave it unused are rejected before running.
+			bool MatchGroupedValues (size_t valueAt)
+			{
+				auto const & entry = *opts->shortOptions.Find(opts->ShortOptionKey((*iter)[valueAt]));
+				auto const & tree = opts->overloadTrees[entry.tree];
+				auto const groupIter = iter;
+				if (!Step()) {
+					return false;
+				}
+				bool success;
+				if (valueAt + 1 == iter->size()) {
+					++iter.iter;
+					success = TryArguments(tree);
+				}
+				else {
+					AttachValue(valueAt + 1);
+					success = TryArguments(tree, std::vector<OverloadRef>(), IterIndex() + 1);
+					parseMemos.clear();
+				}
+				if (!success) {
+					iter = groupIter;
+				}
+				return success;
+			}
+
+			// Records a rejected argument so a failed run reports its message at that argument.
+			void Reject (size_t argIndex, String const & message)
+			{
+				iterHighMark = argIndex;
+				rejectMessageWithHighMark = std::make_pair(message, iterHighMark);
+			}
+
+			// Hits only count overloads whose callbacks ran, not those matched after a failed run collecting errors.
+			void CountHit (OptInfo<Char> const & info) const
+			{
+				if (!suppressCallbacks) {
+					info.hits.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+
+			// Parses the arguments of an overload whose keyword has been matched, then runs its callback.
+			// The overload is rejected before its callback runs unless the arguments reach minEndIndex.
+			bool TryOverload (OptInfo<Char> const & info, size_t minEndIndex = 0)
+			{
+				size_t const arity = info.typeKinds.size();
+				size_t const argParseIndex = IterIndex();
+				auto const & typeKinds = info.typeKinds;
+				size_t minTokens = 0;
+				for (auto const & typeKind : typeKinds) {
+					minTokens += typeKind.minTokens;
+				}
+				if (minTokens > static_cast<size_t>(end.iter - iter.iter)) {
+					return false;
+				}
+				auto const & tree = opts->overloadTrees[info.treeIndex];
+				soleOverload = tree.exclusive && tree.overloadCount == 1 && tree.keyword.prefixes.empty();
+				std::vector<ParseMemo> parsedSpans;
+				OpaqueValues parsedArgs = ParseArgs(typeKinds, parsedSpans);
+				soleOverload = false;
+				if (parsedArgs.size() != arity || IterIndex() < minEndIndex) {
+					ForgetParsedArgs(typeKinds, parsedArgs, parsedSpans);
+					return false;
+				}
+				if (aborted) {
+					return false;
+				}
+				if (info.countSlot != static_cast<size_t>(-1)) {
+					if (flagCounts[info.countSlot]++ == 0) {
+						flagIndices[info.countSlot] = optionIndex;
+					}
+					CountHit(info);
+					return true;
+				}
+				if (info.batchSlot != static_cast<size_t>(-1)) {
+					auto const & collected = opts->collectedOptions[info.batchSlot];
+					if (collected.second.empty(batches[info.batchSlot].get())) {
+						batchIndices[info.batchSlot] = optionIndex;
+					}
+					collected.second.append(batches[info.batchSlot].get(), parsedArgs[0].get());
+					CountHit(info);
+					return true;
+				}
+				bool given = true;
+				if (info.keyword.negatable) {
+					given = !negatedMatch;
+					parsedArgs.emplace_back(&given, [] (void *) {});
+				}
+#ifndef LAMBDA_OPTIONS_NO_THROW
+				try {
+#endif
+					Verdict<Char> const verdict = suppressCallbacks ? Verdict<Char>::Accept() : info.callback(parsedArgs);
+					if (verdict.accepted) {
+						CountHit(info);
+						return true;
+					}
+					Reject(argParseIndex + verdict.argIndex, verdict.message);
+#ifndef LAMBDA_OPTIONS_NO_THROW
+				}
+				catch (RejectArgumentException<Char> const & e) {
+					Reject(argParseIndex + e.argIndex, e.message);
+				}
+#endif
+				return false;
+			}
+
+			bool TryParse (bool useKeyword, std::vector<OptInfo<Char>> const & infos)
+			{
+				if (infos.empty()) {
+					return false;
+				}
+
+				auto const startIter = iter;
+
+				for (auto const & info : infos) {
+					if (info.keyword.names.empty() == useKeyword) {
+						continue;
+					}
+					iter = startIter;
+					if (MatchKeyword(info.keyword) && TryOverload(info)) {
+						return true;
+					}
+				}
+
+				iter = startIter;
+				return false;
 			}
 
-
-			template <typename T>
-			void AddDynamicParser ()
+			bool TryParse (bool useKeyword, std::vector<std::vector<OptInfo<Char>>> const & infosByArity)
 			{
-				TypeId typeKind = TypeId::Get<T>();
-				if (_private::Lookup(dynamicParserMap, typeKind) == nullptr) {
-					auto parser = OpaqueParse<Char, T>;
-					dynamicParserMap.emplace_back(std::move(typeKind), parser);
+				auto const itEnd = infosByArity.rend();
+				for (auto it = infosByArity.rbegin(); it != itEnd; ++it) {
+					auto & infos = *it;
+					if (TryParse(useKeyword, infos)) {
+						return true;
+					}
 				}
+				return false;
 			}
 
-
-			typename OpaqueParser<Char>::Type LookupDynamicParser (TypeId const & k) const
+			static bool HasUnrejected (OverloadTree<Char> const & tree, size_t nodeIndex, std::vector<OverloadRef> const & rejected)
 			{
-				auto const * pParser = _private::Lookup(dynamicParserMap, k);
-				Assert(__LINE__, pParser != nullptr);
-				return *pParser;
+				auto const & node = tree.nodes[nodeIndex];
+				for (OverloadRef const & ref : node.overloads) {
+					if (std::find(rejected.begin(), rejected.end(), ref) == rejected.end()) {
+						return true;
+					}
+				}
+				for (size_t childIndex : node.children) {
+					if (HasUnrejected(tree, childIndex, rejected)) {
+						return true;
+					}
+				}
+				return false;
 			}
 
-
-			template <typename T>
-			void PushTypeId (std::vector<TypeId> & kinds)
+			// Finds the most preferred overload below nodeIndex whose remaining arguments parse. Subtrees that cannot
+			// beat the best overload found so far, or that need more arguments than remain, are not parsed.
+			void SearchOverloads (OverloadTree<Char> const & tree, size_t nodeIndex, std::vector<OverloadRef> const & rejected, bool & found, OverloadRef & best)
 			{
-				kinds.push_back(TypeId::Get<T>());
-				AddDynamicParser<T>();
-			}
-
+				auto const & node = tree.nodes[nodeIndex];
+				for (OverloadRef const & ref : node.overloads) {
+					if ((!found || ref.PreferredOver(best)) && std::find(rejected.begin(), rejected.end(), ref) == rejected.end()) {
+						found = true;
+						best = ref;
+					}
+				}
 
-		public:
-			typename DynamicParserMap<Char>::Type dynamicParserMap;
-			std::vector<std::pair<String, Priority>> helpGroupPriorities;
-			OptionsConfig config;
-			std::vector<std::vector<OptInfo<Char>>> infosByArity;
-		};
+				size_t const remaining = static_cast<size_t>(end.iter - iter.iter);
+				auto const startIter = iter;
+				for (size_t childIndex : node.children) {
+					auto const & child = tree.nodes[childIndex];
+					if (found && !child.best.PreferredOver(best)) {
+						break;
+					}
+					if (child.minTokens > remaining) {
+						continue;
+					}
+					if (!rejected.empty() && !HasUnrejected(tree, childIndex, rejected)) {
+						continue;
+					}
+					std::vector<ParseMemo> parsedSpans;
+					UniqueOpaque parsedArg = ParseArg(child.kind, parsedSpans);
+					if (parsedArg != nullptr) {
+						SearchOverloads(tree, childIndex, rejected, found, best);
+						ForgetParsedArg(child.kind, parsedArg, parsedSpans.back());
+					}
+					iter = startIter;
+				}
+			}
 
+			bool TryParse (OverloadTree<Char> const & tree)
+			{
+				auto const startIter = iter;
+				if (MatchKeyword(tree.keyword) && TryArguments(tree)) {
+					return true;
+				}
+				iter = startIter;
+				return false;
+			}
 
-		template <typename Char>
-		class ParseContextImpl {
-			friend class ArgsIter<Char>;
+			// Runs the most preferred overload of tree whose arguments parse from iter, which is past the keyword.
+			bool TryArguments (OverloadTree<Char> const & tree)
+			{
+				return TryArguments(tree, std::vector<OverloadRef>());
+			}
 
-			typedef LAMBDA_OPTIONS_NAMESPACE::_private::OptionsImpl<Char> OptionsImpl;
-			typedef std::basic_string<Char> String;
-			typedef typename String::const_iterator StringIter;
+			// As above, but never runs the overloads initially in rejected, nor those whose arguments end before minEndIndex.
+			bool TryArguments (OverloadTree<Char> const & tree, std::vector<OverloadRef> rejected, size_t minEndIndex = 0)
+			{
+				auto const startIter = iter;
+				for (;;) {
+					bool found = false;
+					OverloadRef best(0, 0);
+					if (tree.overloadCount == 1) {
+						// A lone overload needs no search, so TryOverload parses its arguments only once.
+						best = tree.nodes[0].best;
+						found = std::find(rejected.begin(), rejected.end(), best) == rejected.end();
+					}
+					else {
+						SearchOverloads(tree, 0, rejected, found, best);
+					}
+					if (!found) {
+						break;
+					}
+					if (TryOverload(opts->infosByArity[best.arity][best.index], minEndIndex)) {
+						return true;
+					}
+					rejected.push_back(best);
+					iter = startIter;
+				}
+				iter = startIter;
+				return false;
+			}
 
-		private:
-			ParseContextImpl (ParseContextImpl const &); // disable
-			void operator= (ParseContextImpl const &);   // disable
+			// Finds the position in keywordTreeOrder of a keyword matching the current argument. An exclusive keyword
+			// ends the search. Otherwise, the search continues so that a second match can be reported through ambiguous.
+			size_t FindKeywordTree (bool & ambiguous) const
+			{
+				return FindKeywordTree(iter->begin(), iter->end(), ambiguous);
+			}
 
-		public:
-			ParseContextImpl (std::shared_ptr<OptionsImpl const> opts, std::vector<String> && args, void * userData)
-				: opts(opts)
-				, args(std::move(args))
-				, begin(this->args.begin(), this->args.end(), this)
-				, end(this->args.end(), this->args.end(), this)
-				, iter(begin)
-				, parseState(iter, end, userData)
-				, iterHighMark(0)
-				, userData(userData)
-			{}
+			// As above, for a name that is only part of the current argument.
+			size_t FindKeywordTree (typename String::const_iterator nameBegin, typename String::const_iterator nameEnd, bool & ambiguous) const
+			{
+				ambiguous = false;
+				size_t match = static_cast<size_t>(-1);
+				for (size_t pos = 0; pos < keywordTreeOrder.size(); ++pos) {
+					auto const & tree = opts->overloadTrees[keywordTreeOrder[pos]];
+					if (!MatchesKeyword(tree.keyword, nameBegin, nameEnd)) {
+						continue;
+					}
+					if (match != static_cast<size_t>(-1)) {
+						ambiguous = true;
+						break;
+					}
+					match = pos;
+					if (tree.exclusive) {
+						break;
+					}
+				}
+				return match;
+			}
 
-			std::vector<String> const & Args () const
+			void KeywordTreeMatched (size_t pos)
 			{
-				return args;
+				if (opts->config.adaptiveOrdering && pos != 0) {
+					size_t const treeIndex = keywordTreeOrder[pos];
+					keywordTreeOrder.erase(keywordTreeOrder.begin() + static_cast<std::ptrdiff_t>(pos));
+					keywordTreeOrder.insert(keywordTreeOrder.begin(), treeIndex);
+				}
 			}
 
-			bool Run (ParseFailedException<Char> & e)
+			// Matches an argument of the form --name=value, or /name:value with Windows keywords, when no keyword matches
+			// it whole. The name is compared in place, and the overloads then see the value in place of the argument.
+			// If several keywords match the name, their overloads are tried in order, as TryParse does.
+			bool MatchAttachedValue ()
 			{
-				iter = begin;
-				while (TryParse()) {
-					continue;
+				Char separator;
+				switch (opts->config.keywordStyle) {
+					case KeywordStyle::Gnu: {
+						separator = '=';
+					} break;
+					case KeywordStyle::Windows: {
+						separator = ':';
+					} break;
+					default: {
+						return false;
+					}
 				}
-				if (iter == end) {
-					return true;
+
+				size_t const valueAt = iter->find(separator) + 1;
+				if (valueAt == 0 || valueAt == 1) {
+					return false;
 				}
-				size_t const currArgIndex = static_cast<size_t>(iter.iter - begin.iter);
-				if (rejectMessageWithHighMark.second == iterHighMark) {
-					e = ParseFailedException<Char>(currArgIndex, iterHighMark + 1, args, rejectMessageWithHighMark.first);
+				auto const nameBegin = iter->begin();
+				auto const nameEnd = nameBegin + static_cast<std::ptrdiff_t>(valueAt - 1);
+				bool ambiguous;
+				size_t const pos = FindKeywordTree(nameBegin, nameEnd, ambiguous);
+				if (pos == static_cast<size_t>(-1)) {
+					return false;
 				}
-				else {
-					e = ParseFailedException<Char>(currArgIndex, iterHighMark + 1, args);
+				if (ambiguous) {
+					return MatchAttachedValue(nameBegin, nameEnd, valueAt);
 				}
-				return false;
+				if (!MatchAttachedValue(opts->overloadTrees[keywordTreeOrder[pos]], valueAt)) {
+					return false;
+				}
+				KeywordTreeMatched(pos);
+				return true;
 			}
 
-		private:
-			UniqueOpaque OpaqueParse (TypeId const & typeKind)
+			// Parses the arguments of tree starting with the value at valueAt within the current argument.
+			// Overloads that would leave the value unused are rejected before their callbacks run.
+			bool MatchAttachedValue (OverloadTree<Char> const & tree, size_t valueAt)
 			{
-				auto parser = opts->LookupDynamicParser(typeKind);
-				return parser(parseState);
+				auto const startIter = iter;
+				if (!Step()) {
+					return false;
+				}
+				AttachValue(valueAt);
+				bool const success = TryArguments(tree, tree.nodes[0].overloads, IterIndex() + 1);
+				parseMemos.clear();
+				if (!success) {
+					iter = startIter;
+				}
+				return success;
 			}
 
-			OpaqueValues ParseArgs (std::vector<TypeId> const & typeKinds)
+			// As above, trying the overloads of every keyword whose names match the name before the value.
+			bool MatchAttachedValue (typename String::const_iterator nameBegin, typename String::const_iterator nameEnd, size_t valueAt)
 			{
-				size_t const N = typeKinds.size();
-				OpaqueValues parsedArgs;
-				for (size_t i = 0; i < N; ++i) {
-					TypeId const & typeKind = typeKinds[i];
-					UniqueOpaque parsedArg = OpaqueParse(typeKind);
-					if (parsedArg == nullptr) {
-						break;
+				auto const startIter = iter;
+				if (!Step()) {
+					return false;
+				}
+				AttachValue(valueAt);
+				auto const valueIter = iter;
+				size_t const minEndIndex = IterIndex() + 1;
+				bool success = false;
+				for (size_t arity = opts->infosByArity.size(); arity-- > 1 && !success; ) {
+					for (auto const & info : opts->infosByArity[arity]) {
+						iter = valueIter;
+						if (MatchesKeyword(info.keyword, nameBegin, nameEnd) && TryOverload(info, minEndIndex)) {
+							success = true;
+							break;
+						}
 					}
-					parsedArgs.emplace_back(std::move(parsedArg));
 				}
-				return parsedArgs;
+				parseMemos.clear();
+				if (!success) {
+					iter = startIter;
+				}
+				return success;
 			}
 
-			bool MatchKeyword (Keyword<Char> const & keyword)
+			// Makes the current argument appear to the parsers as its part from valueAt on.
+			void AttachValue (size_t valueAt)
 			{
-				if (keyword.names.empty()) {
-					return true;
-				}
-				for (String const & name : keyword.names) {
-					if (MatchesName(opts->config.matchFlags, *iter, name)) {
-						++iter;
-						return true;
-					}
-				}
-				return false;
+				attachedValue.assign(*iter, valueAt, String::npos);
+				iter.attached = &attachedValue;
+				parseMemos.clear();
 			}
 
-			bool IsKeyword (String const & str) const
+			// Matches an argument beginning with a keyword prefix. Longer prefixes are tried first.
+			bool MatchJoinedPrefix ()
 			{
-				auto const & infosByArity = opts->infosByArity;
-				for (auto const & infos : infosByArity) {
-					for (auto const & info : infos) {
-						for (auto const & name : info.keyword.names) {
-							if (MatchesName(opts->config.matchFlags, str, name)) {
-								return true;
-							}
+				String const & arg = *iter;
+				auto const & joinedPrefixes = opts->joinedPrefixes;
+				typename PrefixTrie<Char>::Node const * node = nullptr;
+				for (size_t length = joinedPrefixes.Longest(arg, arg.size(), node); length != 0; length = joinedPrefixes.Longest(arg, length - 1, node)) {
+					for (size_t treeIndex : node->trees) {
+						if (MatchJoinedPrefix(opts->overloadTrees[treeIndex], length)) {
+							return true;
 						}
 					}
 				}
 				return false;
 			}
 
-			bool MatchGnuShortGrouping ()
+			// Parses the arguments of tree for the current argument, which begins with a prefix of the given length.
+			bool MatchJoinedPrefix (OverloadTree<Char> const & tree, size_t length)
 			{
-				if ((opts->config.matchFlags & MatchFlags::GnuShortGrouping) == MatchFlags::Empty) {
+				if (length < iter->size()) {
+					return MatchAttachedValue(tree, length);
+				}
+				auto const startIter = iter;
+				if (!Step()) {
 					return false;
 				}
+				++iter.iter;
+				if (TryArguments(tree, tree.nodes[0].overloads)) {
+					return true;
+				}
+				iter = startIter;
+				return false;
+			}
 
-				String const & groupedArgs = *iter;
-				if (groupedArgs.size() < 3 || groupedArgs[0] != '-' || groupedArgs[1] == '-') {
+			// Passes the current argument, with the arguments after it that cannot start an option, to the positional batch.
+			bool MatchPositionalBatch ()
+			{
+				if (!opts->positionalBatch) {
 					return false;
 				}
+				size_t const endIndex = static_cast<size_t>(end.iter - begin.iter);
+				size_t last = IterIndex() + 1;
+				while (last < endIndex && !opts->leadCharacters.MayStart(args[last])) {
+					++last;
+				}
+				return MatchBatch(opts->positionalBatch, last);
+			}
 
-				std::vector<std::vector<String>> artificialArgss;
-				artificialArgss.reserve(groupedArgs.size() - 1);
-
-				for (size_t i = 1; i < groupedArgs.size(); ++i) {
-					artificialArgss.emplace_back(1, String(2, '-'));
-					auto & artificialArgs = artificialArgss.back();
-					String & artificialArg = artificialArgs[0];
-					artificialArg[1] = groupedArgs[i];
-					if (!IsKeyword(artificialArg)) {
-						return false;
-					}
+			// Resolves an argument after the "--" that ends the options, without looking at any keyword.
+			bool MatchRest ()
+			{
+				size_t const endIndex = static_cast<size_t>(end.iter - begin.iter);
+				if (opts->restHandler) {
+					return MatchBatch(opts->restHandler, endIndex);
 				}
+				if (opts->positionalBatch) {
+					return MatchBatch(opts->positionalBatch, endIndex);
+				}
+				return TryParse(false);
+			}
 
-				for (auto & artificialArgs : artificialArgss) {
-					ParseContextImpl<Char> parseContext(opts, std::move(artificialArgs), userData);
+			// Passes the arguments from iter up to the one at last to handler at once.
+			bool MatchBatch (typename OptionsImpl::BatchHandler const & handler, size_t last)
+			{
+				if (!Step()) {
+					return false;
+				}
+				size_t const first = IterIndex();
 #ifndef LAMBDA_OPTIONS_NO_THROW
-					try {
+				try {
 #endif
-						ParseFailedException<Char> e;
-						if (!parseContext.Run(e)) {
-							return false;
-						}
-#ifndef LAMBDA_OPTIONS_NO_THROW
-					}
-					catch (RejectArgumentException<Char> const &) {
-						return false;
+					Span<String const> const batch(&args[first], last - first);
+					Verdict<Char> const verdict = suppressCallbacks ? Verdict<Char>::Accept() : handler(batch);
+					if (verdict.accepted) {
+						iter.iter += static_cast<std::ptrdiff_t>(last - first);
+						return true;
 					}
-#endif
+					Reject(first + verdict.argIndex, verdict.message);
+#ifndef LAMBDA_OPTIONS_NO_THROW
+				}
+				catch (RejectArgumentException<Char> const & e) {
+					Reject(first + e.argIndex, e.message);
 				}
+#endif
+				return false;
+			}
 
-				++iter;
+			// Resolves against the one keyword whose names match the current argument. If several keywords match,
+			// their overloads are interleaved by preference, so every overload is tried in order instead.
+			bool TryParse (bool useKeyword)
+			{
+				if (!useKeyword) {
+					size_t const treeIndex = opts->keywordlessTree;
+					return treeIndex != static_cast<size_t>(-1) && TryParse(opts->overloadTrees[treeIndex]);
+				}
+				bool ambiguous;
+				size_t const pos = FindKeywordTree(ambiguous);
+				if (ambiguous) {
+					return TryParse(useKeyword, opts->infosByArity);
+				}
+				if (pos == static_cast<size_t>(-1) || !TryParse(opts->overloadTrees[keywordTreeOrder[pos]])) {
+					return false;
+				}
+				KeywordTreeMatched(pos);
 				return true;
 			}
 
-			bool TryParse (bool useKeyword, std::vector<OptInfo<Char>> const & infos)
+			// Resolves the argument by its keyword alone, falling back to an attached value, the positional batch and then
+			// the keyword-less option only when no keyword matches. An argument starting with a prefix can only be that
+			// prefix's option, so it is found in the prefix trie without looking at the names.
+			// There is one overload per keyword in deterministic mode, so no alternative is tried if it fails.
+			bool TryParseDeterministic ()
 			{
-				if (infos.empty()) {
+				typename PrefixTrie<Char>::Node const * node = nullptr;
+				size_t const length = opts->joinedPrefixes.Longest(*iter, iter->size(), node);
+				if (length != 0) {
+					return MatchJoinedPrefix(opts->overloadTrees[node->trees.front()], length);
+				}
+				bool ambiguous;
+				size_t const pos = FindKeywordTree(ambiguous);
+				if (pos == static_cast<size_t>(-1) && (MatchAttachedValue() || MatchPositionalBatch())) {
+					return true;
+				}
+				size_t const treeIndex = pos != static_cast<size_t>(-1) ? keywordTreeOrder[pos] : opts->keywordlessTree;
+				if (treeIndex == static_cast<size_t>(-1)) {
 					return false;
 				}
 
+				auto const & tree = opts->overloadTrees[treeIndex];
 				auto const startIter = iter;
-
-				for (auto const & info : infos) {
-					size_t const arity = info.typeKinds.size();
-					if (info.keyword.names.empty() == useKeyword) {
-						continue;
-					}
-					iter = startIter;
-					if (MatchKeyword(info.keyword)) {
-						size_t const argParseIndex = static_cast<size_t>(iter.iter - begin.iter);
-#ifdef LAMBDA_OPTIONS_NO_THROW
-						(void) argParseIndex;
-#endif
-						auto const & typeKinds = info.typeKinds;
-						Assert(__LINE__, typeKinds.size() == arity);
-						OpaqueValues parsedArgs = ParseArgs(typeKinds);
-						if (parsedArgs.size() == arity) {
-#ifndef LAMBDA_OPTIONS_NO_THROW
-							try {
-#endif
-								info.callback(parsedArgs);
-								return true;
-#ifndef LAMBDA_OPTIONS_NO_THROW
-							}
-							catch (RejectArgumentException<Char> const & e) {
-								iterHighMark = argParseIndex + e.argIndex;
-								rejectMessageWithHighMark = std::make_pair(e.message, iterHighMark);
-							}
-#endif
-						}
+				OverloadRef const & ref = tree.nodes[0].best;
+				MatchKeyword(tree.keyword);
+				if (TryOverload(opts->infosByArity[ref.arity][ref.index])) {
+					if (pos != static_cast<size_t>(-1)) {
+						KeywordTreeMatched(pos);
 					}
+					return true;
 				}
-
 				iter = startIter;
 				return false;
 			}
 
-			bool TryParse (std::vector<std::vector<OptInfo<Char>>> const & infosByArity)
-			{
-				bool const useKeywordState[] = { true, false };
-				for (bool useKeyword : useKeywordState) {
-					auto const itEnd = infosByArity.rend();
-					for (auto it = infosByArity.rbegin(); it != itEnd; ++it) {
-						auto & infos = *it;
-						if (TryParse(useKeyword, infos)) {
-							return true;
-						}
-					}
-				}
-				return false;
-			}
-
 			bool TryParse ()
 			{
-				if (iter == end) {
+				parseMemos.clear();
+				if (iter == end || aborted) {
 					return false;
 				}
-				if (MatchGnuShortGrouping()) {
+				optionIndex = IterIndex();
+				negatedMatch = false;
+				if (optionsEnded) {
+					return MatchRest();
+				}
+				if (opts->config.endOfOptions && iter->size() == 2 && (*iter)[0] == '-' && (*iter)[1] == '-') {
+					if (!Step()) {
+						return false;
+					}
+					++iter.iter;
+					optionsEnded = true;
+					return true;
+				}
+				if (opts->positionalBatch && !opts->leadCharacters.MayStart(*iter)) {
+					return MatchPositionalBatch();
+				}
+				bool grouped;
+				if (MatchGnuShortGrouping(grouped)) {
 					return true;
 				}
-				return TryParse(opts->infosByArity);
+				if (opts->config.deterministic) {
+					return !grouped && TryParseDeterministic();
+				}
+				return TryParse(true) || MatchAttachedValue() || MatchJoinedPrefix() || MatchPositionalBatch() || TryParse(false);
 			}
 
 		public:
 			std::shared_ptr<OptionsImpl const> opts;
-			std::vector<String> args;
+			std::shared_ptr<std::vector<String>> sharedArgs; // shared with any ParseFailedException
+			std::vector<String> const & args;
 			ArgsIter<Char> const begin;
 			ArgsIter<Char> const end;
 			ArgsIter<Char> iter;
 			ParseState<Char> parseState;
 			size_t iterHighMark;
 			std::pair<String, size_t> rejectMessageWithHighMark;
+			std::vector<ParseMemo> parseMemos;
+			std::vector<size_t> keywordTreeOrder;
+			String attachedValue; // the value seen in place of an argument with an attached or grouped value, reused to avoid allocating
+			std::vector<std::unique_ptr<String>> pinnedValues; // attached values kept for Lazy<T>, see PinAttached
+			ParseLimits limits;
+			size_t steps;
+			bool aborted;
+			ParseFailure abortReason;
+			bool suppressCallbacks; // set once a run collecting errors has failed
+			std::vector<size_t> flagCounts; // the occurrences of each counted option, by OptInfo::countSlot
+			std::vector<size_t> flagIndices; // the argument index of each counted option's first occurrence
+			std::vector<UniqueOpaque> batches; // the values of each collected option, by OptInfo::batchSlot
+			std::vector<size_t> batchIndices; // the argument index of each collected option's first occurrence
+			size_t optionIndex; // the index of the argument being resolved by TryParse
+			bool soleOverload; // set while TryOverload parses an overload no other can compete with, see SoleOverload
+			std::vector<std::pair<void const *, UniqueOpaque>> spanScratches; // the SpanScratch of each output span option, by binding
+			bool negatedMatch; // set when MatchKeyword matched a "no-" name, read by TryOverload for a negatable option
+			bool optionsEnded; // set once the "--" that ends the options has been passed
 			void * userData;
+#ifdef LAMBDA_OPTIONS_FILE_MAPPING
+			std::vector<std::pair<String, std::unique_ptr<MappedFile>>> mappedFiles;
+#endif
 		};
 	}
 
@@ -2254,17 +5687,70 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 		{}
 
 
+		// Returns OptionError::None once the option is added. A bad option throws the matching
+		// OptionException, or under LAMBDA_OPTIONS_NO_THROW is not added and its error is returned.
+		template <typename Func>
+		OptionError AddOption (String const & keyword, Func const & func)
+		{
+			Keyword<Char> kw(keyword);
+			return impl->template AddOption<Func>(kw, func);
+		}
+
+		template <typename Func>
+		OptionError AddOption (Keyword<Char> const & keyword, Func const & func)
+		{
+			return impl->template AddOption<Func>(keyword, func);
+		}
+
+		// Parses the option's values into the caller-owned destination, and the callback takes a Span<T> of them.
+		// If no other overload shares the keyword, elements are written as they are parsed, so a parse that fails at
+		// this option can leave some of them written. Otherwise they are only written when this overload is chosen.
+		template <typename T, typename Func>
+		OptionError AddOption (String const & keyword, Span<T> destination, Func const & func)
+		{
+			Keyword<Char> kw(keyword);
+			return impl->template AddOption<T, Func>(kw, destination, func);
+		}
+
+		template <typename T, typename Func>
+		OptionError AddOption (Keyword<Char> const & keyword, Span<T> destination, Func const & func)
+		{
+			return impl->template AddOption<T, Func>(keyword, destination, func);
+		}
+
+		// Gathers the value of every occurrence of the option into one batch. The callback takes a std::vector<T>
+		// and runs once at the end of a parse, if the option was given. T is usually a std::tuple of the arguments.
+		// If it rejects, the parse fails at the option's first occurrence. Taking the std::vector by reference
+		// lets a ParseContext reuse its storage on the next run. The keyword cannot be negatable or counted.
 		template <typename Func>
-		void AddOption (String const & keyword, Func const & func)
+		OptionError AddCollectedOption (String const & keyword, Func const & func)
 		{
 			Keyword<Char> kw(keyword);
-			impl->template AddOption<Func>(kw, func);
+			return impl->template AddCollectedOption<Func>(kw, func);
+		}
+
+		template <typename Func>
+		OptionError AddCollectedOption (Keyword<Char> const & keyword, Func const & func)
+		{
+			return impl->template AddCollectedOption<Func>(keyword, func);
 		}
 
+		// Passes each run of consecutive arguments that cannot start an option to func at once, as a
+		// Span<String const> of the arguments. An argument that starts like an option is only passed if no option
+		// matches it. The batch is tried before the keyword-less option, and only one can be added.
+		// An unknown option such as -x is therefore batched rather than failing the parse, so no names are suggested.
 		template <typename Func>
-		void AddOption (Keyword<Char> const & keyword, Func const & func)
+		OptionError AddPositionalBatch (Func const & func)
 		{
-			impl->template AddOption<Func>(keyword, func);
+			return impl->template AddPositionalBatch<Func>(func);
+		}
+
+		// Passes every argument after the "--" that ends the options to func at once, as a Span<String const> of the
+		// arguments. See OptionsConfig::endOfOptions. Only one can be added.
+		template <typename Func>
+		OptionError AddRestHandler (Func const & func)
+		{
+			return impl->template AddRestHandler<Func>(func);
 		}
 
 		String HelpDescription () const
@@ -2282,6 +5768,19 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 			impl->SetHelpGroupPriority(group, priority);
 		}
 
+		// How many times each overload has matched, in the order the overloads were added.
+		std::vector<size_t> OverloadHits () const
+		{
+			return impl->OverloadHits();
+		}
+
+		// Looks up keywords in descending order of the given hits, which are laid out like OverloadHits().
+		// Parse contexts created afterwards use this order. The overload that matches an argument does not change.
+		void LoadOverloadProfile (std::vector<size_t> const & hits)
+		{
+			impl->LoadOverloadProfile(hits);
+		}
+
 		template <typename StringIter>
 		ParseContext<Char> CreateParseContext (StringIter begin, StringIter end) const;
 
@@ -2339,6 +5838,7 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 			void FormatKeywordNames (Keyword<Char> const & keyword)
 			{
 				std::vector<String> names = keyword.names;
+				names.insert(names.end(), keyword.prefixes.begin(), keyword.prefixes.end());
 				std::sort(names.begin(), names.end(), [] (String const & n1, String const & n2) {
 					if (n1.size() < n2.size()) {
 						return true;
@@ -2492,14 +5992,18 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 	ArgsIter<Char> & ArgsIter<Char>::operator++ ()
 	{
 		using namespace _private;
-#ifndef LAMBDA_OPTIONS_NO_THROW
 		if (iter == end) {
+#ifndef LAMBDA_OPTIONS_NO_THROW
 			throw IteratorException("Cannot increment past 'end' iterator.");
-		}
+#else
+			return *this;
 #endif
+		}
 		++iter;
+		attached = nullptr;
 		auto & parseContext = *static_cast<ParseContextImpl<Char> *>(opaqueParseContext);
 		parseContext.iterHighMark = std::max(parseContext.iterHighMark, Index());
+		parseContext.Step();
 		return *this;
 	}
 
@@ -2591,13 +6095,15 @@ namespace LAMBDA_OPTIONS_NAMESPACE
 				if (p1 > p2) {
 					return false;
 				}
-				if (kw1->names.empty()) {
+				if (Keywordless(*kw1)) {
 					return true;
 				}
-				if (kw2->names.empty()) {
+				if (Keywordless(*kw2)) {
 					return false;
 				}
-				return kw1->names.front() < kw2->names.front();
+				String const & name1 = kw1->names.empty() ? kw1->prefixes.front() : kw1->names.front();
+				String const & name2 = kw2->names.empty() ? kw2->prefixes.front() : kw2->names.front();
+				return name1 < name2;
 			});
 
 			Formatter<Char> formatter(formatConfig);
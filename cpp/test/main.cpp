@@ -1,7 +1,10 @@
+#define LAMBDA_OPTIONS_FILE_MAPPING
 #include "../src/LambdaOptions.h"
 
 #include <algorithm>
 #include <clocale>
+#include <cstdio>
+#include <cstdlib>
 #include <cwchar>
 #include <iostream>
 #include <sstream>
@@ -117,6 +120,165 @@ namespace lambda_options
 //////////////////////////////////////////////////////////////////////////
 
 
+#if LAMBDA_OPTIONS_VARIADIC_TEMPLATES
+template <typename Char>
+struct TestAggregate {
+	int id;
+	std::basic_string<Char> name;
+	std::array<float, 2> pos;
+};
+
+
+struct TestAggregateLifetime {
+	TestMaybeLifetimeHelper first;
+	TestMaybeLifetimeHelper second;
+	int num;
+};
+
+
+namespace lambda_options
+{
+	template <typename Char>
+	struct RawParser<Char, TestAggregate<Char>> : public AggregateParser<Char, TestAggregate<Char>,
+		LAMBDA_OPTIONS_MEMBER(TestAggregate<Char>, id),
+		LAMBDA_OPTIONS_MEMBER(TestAggregate<Char>, name),
+		LAMBDA_OPTIONS_MEMBER(TestAggregate<Char>, pos)> {};
+
+
+	template <typename Char>
+	struct RawParserTraits<Char, TestAggregate<Char>> : public RawParser<Char, TestAggregate<Char>>::Traits {};
+
+
+	template <typename Char>
+	struct RawParser<Char, TestAggregateLifetime> : public AggregateParser<Char, TestAggregateLifetime,
+		LAMBDA_OPTIONS_MEMBER(TestAggregateLifetime, first),
+		LAMBDA_OPTIONS_MEMBER(TestAggregateLifetime, second),
+		LAMBDA_OPTIONS_MEMBER(TestAggregateLifetime, num)> {};
+}
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////
+
+
+class TestLazyHelper {
+public:
+	static int conversions;
+	static int validations;
+
+	int value;
+};
+
+
+int TestLazyHelper::conversions = 0;
+int TestLazyHelper::validations = 0;
+
+
+namespace lambda_options
+{
+	template <typename Char>
+	struct RawParser<Char, TestLazyHelper> {
+		bool operator() (ParseState<Char> & parseState, void * rawMemory)
+		{
+			++TestLazyHelper::conversions;
+			Maybe<int> mNum;
+			if (Parse<Char, int>(parseState, mNum)) {
+				TestLazyHelper helper = { *mNum };
+				new (rawMemory) TestLazyHelper(helper);
+				return true;
+			}
+			return false;
+		}
+	};
+
+
+	template <typename Char>
+	struct RawValidator<Char, TestLazyHelper> {
+		bool operator() (ParseState<Char> & parseState)
+		{
+			++TestLazyHelper::validations;
+			if (parseState.iter->empty()) {
+				return false;
+			}
+			++parseState.iter;
+			return true;
+		}
+	};
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+
+
+struct TestRangeHelper {
+	static int parses;
+
+	int low;
+	int high;
+};
+
+
+int TestRangeHelper::parses = 0;
+
+
+namespace lambda_options
+{
+	template <typename Char>
+	struct RawParserTraits<Char, TestRangeHelper> {
+		static bool const AllowsEmptyRange = false;
+		static size_t const MinTokens = 2;
+		static size_t const MaxTokens = 2;
+
+		static bool CanStartWith (std::basic_string<Char> const & token)
+		{
+			return !token.empty() && '0' <= token[0] && token[0] <= '9';
+		}
+	};
+
+
+	template <typename Char>
+	struct RawParser<Char, TestRangeHelper> {
+		bool operator() (ParseState<Char> & parseState, void * rawMemory)
+		{
+			++TestRangeHelper::parses;
+			Maybe<std::pair<int, int>> mRange;
+			if (Parse<Char, std::pair<int, int>>(parseState, mRange)) {
+				TestRangeHelper range = { mRange->first, mRange->second };
+				new (rawMemory) TestRangeHelper(range);
+				return true;
+			}
+			return false;
+		}
+	};
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+
+
+// Needs an argument to be present, but does not consume it.
+struct TestPeekHelper {
+	bool present;
+};
+
+
+namespace lambda_options
+{
+	template <typename Char>
+	struct RawParser<Char, TestPeekHelper> {
+		bool operator() (ParseState<Char> &, void * rawMemory)
+		{
+			TestPeekHelper peek = { true };
+			new (rawMemory) TestPeekHelper(peek);
+			return true;
+		}
+	};
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+
+
 template <typename T, size_t N>
 static bool Equal (std::vector<T> const & xs, T const (&ys)[N])
 {
@@ -964,6 +1126,274 @@ public:
 	}
 
 
+#if LAMBDA_OPTIONS_VARIADIC_TEMPLATES
+	static void TestTuples ()
+	{
+		std::wstringstream ss;
+
+		Opts opts(testConfig);
+		opts.AddOption(Q("tup"), [&] (std::tuple<int, String, Char> x) {
+			DumpMemo(ss, L"<tuple>");
+			Dump(ss, std::get<0>(x));
+			Dump(ss, std::get<1>(x));
+			Dump(ss, std::get<2>(x));
+			DumpMemo(ss, L"</tuple>");
+		});
+		opts.AddOption(Q("tup"), [&] (std::tuple<int, int>) {
+			DumpMemo(ss, L"<tuple/>");
+		});
+		opts.AddOption(Q("tup0"), [&] (std::tuple<>) {
+			DumpMemo(ss, L"<tuple0/>");
+		});
+		opts.AddOption(Q("pair"), [&] (std::pair<unsigned int, std::pair<bool, float>> x) {
+			DumpMemo(ss, L"<pair>");
+			Dump(ss, x.first);
+			Dump(ss, x.second.first);
+			Dump(ss, x.second.second);
+			DumpMemo(ss, L"</pair>");
+		});
+		opts.AddOption(empty, [&] (String x) {
+			Dump(ss, x);
+		});
+
+		std::vector<String> args;
+		std::wstringstream expected;
+
+		args.push_back(Q("tup"));
+		args.push_back(Q("1"));
+		args.push_back(Q("one"));
+		args.push_back(Q("x"));
+		DumpMemo(expected, L"<tuple>");
+		Dump(expected, 1);
+		Dump(expected, L"one");
+		Dump(expected, L'x');
+		DumpMemo(expected, L"</tuple>");
+
+		args.push_back(Q("tup"));
+		args.push_back(Q("2"));
+		args.push_back(Q("3"));
+		args.push_back(Q("yy"));
+		DumpMemo(expected, L"<tuple/>");
+		Dump(expected, L"yy");
+
+		args.push_back(Q("tup0"));
+		DumpMemo(expected, L"<tuple0/>");
+
+		args.push_back(Q("pair"));
+		args.push_back(Q("4"));
+		args.push_back(Q("true"));
+		args.push_back(Q("0.5"));
+		DumpMemo(expected, L"<pair>");
+		Dump(expected, 4u);
+		Dump(expected, true);
+		Dump(expected, 0.5f);
+		DumpMemo(expected, L"</pair>");
+
+		args.push_back(Q("pair"));
+		args.push_back(Q("-4"));
+		Dump(expected, L"pair");
+		Dump(expected, L"-4");
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+
+
+	static void TestTupleLifetime ()
+	{
+		typedef TestMaybeLifetimeHelper Helper;
+
+		int const P1 = Helper::P1;
+		int const P2 = Helper::P2;
+		int & value = Helper::value;
+
+		value = 0;
+
+		Opts opts(testConfig);
+		opts.AddOption(empty, [&] (lambda_options::ParseState<Char> parseState) {
+			{
+				typedef std::tuple<Helper, Helper, int> Tuple;
+				lambda_options::Maybe<Tuple> mObject;
+				if (lambda_options::Parse<Char, Tuple>(parseState, mObject)) {
+					FAIL;
+				}
+				if (value != 2 * P1 + 2 * P2) {
+					FAIL;
+				}
+			}
+			value = 0;
+			{
+				typedef std::pair<Helper, Char> Pair;
+				lambda_options::Maybe<Pair> mObject;
+				if (!lambda_options::Parse<Char, Pair>(parseState, mObject)) {
+					FAIL;
+				}
+				if (value != P1) {
+					FAIL;
+				}
+			}
+			if (value != P1 + P2) {
+				FAIL;
+			}
+			ConsumeRest(parseState);
+		});
+
+		std::vector<String> args(4);
+		args[1] = Q("x");
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+	}
+#endif
+
+
+#if LAMBDA_OPTIONS_VARIADIC_TEMPLATES
+	static void TestAggregates ()
+	{
+		typedef TestMaybeLifetimeHelper Helper;
+		typedef lambda_options::TokenTraits<Char, TestAggregate<Char>> AggregateTraits;
+
+		if (AggregateTraits::MinTokens != 4 || AggregateTraits::MaxTokens != 4) {
+			FAIL;
+		}
+		if (!AggregateTraits::CanStartWith(Q("3")) || AggregateTraits::CanStartWith(Q("three"))) {
+			FAIL;
+		}
+
+		std::wstringstream ss;
+
+		Opts opts(testConfig);
+		opts.AddOption(Q("agg"), [&] (TestAggregate<Char> x) {
+			DumpMemo(ss, L"<aggregate>");
+			Dump(ss, x.id);
+			Dump(ss, x.name);
+			Dump(ss, x.pos[0]);
+			Dump(ss, x.pos[1]);
+			DumpMemo(ss, L"</aggregate>");
+		});
+		opts.AddOption(empty, [&] (lambda_options::ParseState<Char> parseState) {
+			Helper::value = 0;
+			{
+				lambda_options::Maybe<TestAggregateLifetime> mObject;
+				if (lambda_options::Parse<Char, TestAggregateLifetime>(parseState, mObject)) {
+					FAIL;
+				}
+				if (Helper::value != 2 * Helper::P1 + 2 * Helper::P2) {
+					FAIL;
+				}
+			}
+			DumpMemo(ss, L"<rejected/>");
+			ConsumeRest(parseState);
+		});
+
+		std::vector<String> args;
+		std::wstringstream expected;
+
+		args.push_back(Q("agg"));
+		args.push_back(Q("3"));
+		args.push_back(Q("three"));
+		args.push_back(Q("0.5"));
+		args.push_back(Q("1.5"));
+		DumpMemo(expected, L"<aggregate>");
+		Dump(expected, 3);
+		Dump(expected, L"three");
+		Dump(expected, 0.5f);
+		Dump(expected, 1.5f);
+		DumpMemo(expected, L"</aggregate>");
+
+		args.push_back(Q("agg"));
+		args.push_back(Q("4"));
+		args.push_back(Q("four"));
+		args.push_back(Q("0.5"));
+		args.push_back(Q("x"));
+		DumpMemo(expected, L"<rejected/>");
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+#endif
+
+
+#if LAMBDA_OPTIONS_CPP17
+	static void TestOptionalAndVariant ()
+	{
+		std::wstringstream ss;
+
+		Opts opts(testConfig);
+		opts.AddOption(Q("opt"), [&] (std::optional<int> x) {
+			DumpMemo(ss, L"<optional>");
+			if (x) {
+				Dump(ss, *x);
+			}
+			DumpMemo(ss, L"</optional>");
+		});
+		opts.AddOption(Q("var"), [&] (std::variant<unsigned int, bool, String> x) {
+			DumpMemo(ss, L"<variant>");
+			if (auto p = std::get_if<unsigned int>(&x)) {
+				Dump(ss, *p);
+			}
+			if (auto p = std::get_if<bool>(&x)) {
+				Dump(ss, *p);
+			}
+			if (auto p = std::get_if<String>(&x)) {
+				Dump(ss, *p);
+			}
+			DumpMemo(ss, L"</variant>");
+		});
+
+		std::vector<String> args;
+		std::wstringstream expected;
+
+		args.push_back(Q("opt"));
+		args.push_back(Q("7"));
+		DumpMemo(expected, L"<optional>");
+		Dump(expected, 7);
+		DumpMemo(expected, L"</optional>");
+
+		args.push_back(Q("opt"));
+		DumpMemo(expected, L"<optional>");
+		DumpMemo(expected, L"</optional>");
+
+		args.push_back(Q("var"));
+		args.push_back(Q("8"));
+		DumpMemo(expected, L"<variant>");
+		Dump(expected, 8u);
+		DumpMemo(expected, L"</variant>");
+
+		args.push_back(Q("var"));
+		args.push_back(Q("false"));
+		DumpMemo(expected, L"<variant>");
+		Dump(expected, false);
+		DumpMemo(expected, L"</variant>");
+
+		args.push_back(Q("var"));
+		args.push_back(Q("-8"));
+		DumpMemo(expected, L"<variant>");
+		Dump(expected, L"-8");
+		DumpMemo(expected, L"</variant>");
+
+		args.push_back(Q("opt"));
+		DumpMemo(expected, L"<optional>");
+		DumpMemo(expected, L"</optional>");
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+#endif
+
+
 	static void TestCustomParser ()
 	{
 		std::wstringstream ss;
@@ -1147,488 +1577,1137 @@ public:
 	}
 
 
-	static void TestHelpDescription ()
+	static void TestLazy ()
 	{
-		Opts opts(testConfig);
-
-		Keyword kwFoo(Q("foo"));
-		kwFoo.text = Q("Foo does shtuff.");
-		opts.AddOption(kwFoo, nop);
+		typedef TestLazyHelper Helper;
+		typedef lambda_options::Lazy<Helper> LazyHelper;
 
-		Keyword kwBar(Q("bar"), Q('b'));
-		kwBar.text = Q("Bar does even moare shtuff!!!");
-		opts.AddOption(kwBar, nop);
+		std::wstringstream ss;
 
-		Keyword kwRofl(Q("foflcopter"));
-		kwRofl.text = Q("0123456789 01234567890123456789 012345678901234567890123456789 0123456789012345678901234567890123456789");
-		opts.AddOption(kwRofl, nop);
+		Helper::conversions = 0;
+		Helper::validations = 0;
 
-		FormattingConfig config;
-		config.maxWidth = 0;
-		String desc = opts.HelpDescription(config);
+		bool enabled = false;
 
-		auto printString = [] (String const & str) {
-			std::cout << "\n<String>\n";
-			for (Char c : str) {
-				std::cout << static_cast<char>(c);
+		Opts opts(testConfig);
+		opts.AddOption(Q("enable"), [&] () {
+			enabled = true;
+		});
+		opts.AddOption(Q("dump"), [&] (LazyHelper x) {
+			if (enabled) {
+				Dump(ss, x->value);
+				Dump(ss, x.Get().value);
 			}
-			std::cout << "\n</String>\n";
-		};
+		});
+		opts.AddOption(Q("dump"), [&] (LazyHelper x, int y) {
+			if (enabled) {
+				Dump(ss, y);
+				if (x.TryGet() == nullptr) {
+					DumpMemo(ss, L"<unconverted/>");
+				}
+			}
+		});
+		opts.AddOption(Q("name"), [&] (lambda_options::Lazy<String> x) {
+			Dump(ss, *x);
+		});
+		opts.AddOption(empty, [&] (String x) {
+			Dump(ss, x);
+		});
 
-		printString(desc);
-	}
+		std::vector<String> args;
+		std::wstringstream expected;
 
-	static void TestHelpGroups ()
-	{
-		Opts opts(testConfig);
+		args.push_back(Q("dump"));
+		args.push_back(Q("1"));
 
-		Keyword kwFoo(Q("foo"));
-		kwFoo.helpGroup = Q("cake");
-		opts.AddOption(kwFoo, nop);
+		args.push_back(Q("enable"));
 
-		Keyword kwBar(Q("bar"));
-		kwBar.helpGroup = Q("lie");
-		opts.AddOption(kwBar, nop);
+		args.push_back(Q("dump"));
+		args.push_back(Q("2"));
+		Dump(expected, 2);
+		Dump(expected, 2);
 
-		Keyword kwBaz(Q("baz"));
-		kwBaz.helpGroup = Q("cake");
-		opts.AddOption(kwBaz, nop);
+		args.push_back(Q("dump"));
+		args.push_back(Q("x"));
+		args.push_back(Q("3"));
+		Dump(expected, 3);
+		DumpMemo(expected, L"<unconverted/>");
 
-		auto printString = [] (String const & str) {
-			std::cout << "\n<String>\n";
-			for (Char c : str) {
-				std::cout << static_cast<char>(c);
-			}
-			std::cout << "\n</String>\n";
-		};
+		args.push_back(Q("name"));
+		args.push_back(Q("bob"));
+		Dump(expected, L"bob");
 
-		{
-			String desc = opts.HelpDescription();
-			printString(desc);
-		}
-		opts.SetHelpGroupPriority(Q("cake"), 0);
-		opts.SetHelpGroupPriority(Q("lie"), 1);
-		{
-			String desc = opts.HelpDescription();
-			printString(desc);
-		}
-		opts.SetHelpGroupPriority(Q("cake"), 10);
-		opts.SetHelpGroupPriority(Q("lie"), 5);
-		{
-			FormattingConfig config;
-			config.helpGroupFilter.push_back(Q("cake"));
-			String desc = opts.HelpDescription(config);
-			printString(desc);
+		args.push_back(Q("dump"));
+		args.push_back(Q(""));
+		Dump(expected, L"dump");
+		Dump(expected, L"");
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+
+		if (ss.str() != expected.str()) {
+			FAIL;
 		}
-		{
-			FormattingConfig config;
-			config.helpGroupFilter.push_back(Q("cake"));
-			config.helpGroupFilter.push_back(Q("lie"));
-			String desc = opts.HelpDescription(config);
-			printString(desc);
+		if (Helper::conversions != 2) {
+			FAIL;
 		}
-		{
-			FormattingConfig config;
-			config.helpGroupFilter.push_back(Q("lie"));
-			config.helpGroupFilter.push_back(Q("cake"));
-			String desc = opts.HelpDescription(config);
-			printString(desc);
+		if (Helper::validations != 4) {
+			FAIL;
 		}
-		{
-			FormattingConfig config;
-			config.helpGroupFilter.push_back(Q("where"));
-			config.helpGroupFilter.push_back(Q("lie"));
-			config.helpGroupFilter.push_back(Q("waldo"));
-			String desc = opts.HelpDescription(config);
-			printString(desc);
+
+		// A failed conversion is reported as a parse failure at the option and its argument.
+		bool threw = false;
+		opts.AddOption(Q("get"), [&] (LazyHelper x) {
+			try {
+				x.Get();
+			}
+			catch (lambda_options::ParseFailedException<Char> const & e) {
+				threw = true;
+				if (e.beginIndex != 1 || e.endIndex != 3) {
+					FAIL;
+				}
+				if (e.Message() != Q("Bad input for `get' at index 2: `x'")) {
+					FAIL;
+				}
+			}
+		});
+		args.clear();
+		args.push_back(Q("enable"));
+		args.push_back(Q("get"));
+		args.push_back(Q("x"));
+		opts.CreateParseContext(args.begin(), args.end()).Run();
+		if (!threw) {
+			FAIL;
 		}
 	}
 
 
-	static void TestKeywordStyle ()
+	static void TestParseMemo ()
 	{
-		static_assert(KeywordStyle::Default == KeywordStyle::Gnu, "whoops");
+		typedef TestLazyHelper Helper;
 
-		auto testStyle = [&] (KeywordStyle style, String const & inputName, String const expectedName) {
-			std::wstringstream ss;
-
-			OptionsConfig config;
-			config.keywordStyle = style;
-			config.matchFlags = MatchFlags::Empty;
-			Opts opts(config);
+		std::wstringstream ss;
 
-			opts.AddOption(inputName, [&] () {
-				DumpMemo(ss, L(inputName));
-			});
-			opts.AddOption(empty, [&] (String s) {
-				Dump(ss, s);
-			});
+		Helper::conversions = 0;
 
-			std::vector<String> args;
-			std::wstringstream expected;
+		Opts opts(testConfig);
+		opts.AddOption(Q("x"), [&] (Helper a) {
+			Dump(ss, a.value);
+		});
+		opts.AddOption(Q("x"), [&] (Helper a, int b) {
+			Dump(ss, a.value);
+			Dump(ss, b);
+		});
+		opts.AddOption(Q("x"), [&] (Helper a, int b, Helper c) {
+			Dump(ss, a.value);
+			Dump(ss, b);
+			Dump(ss, c.value);
+		});
+		opts.AddOption(Q("x"), [&] (String a) {
+			Dump(ss, a);
+		});
+		opts.AddOption(empty, [&] (String a) {
+			Dump(ss, a);
+		});
 
-			auto pushArg = [&] (String const & arg) {
-				args.push_back(arg);
-				if (arg == expectedName) {
-					DumpMemo(expected, L(inputName));
-				}
-				else {
-					Dump(expected, arg);
-				}
-			};
+		std::vector<String> args;
+		std::wstringstream expected;
 
-			pushArg(Q("foo"));
-			pushArg(Q("-foo"));
-			pushArg(Q("--foo"));
-			pushArg(Q("---foo"));
-			pushArg(Q("/foo"));
-			pushArg(Q("//foo"));
-			pushArg(Q(""));
-			pushArg(Q("f"));
-			pushArg(Q("-"));
-			pushArg(Q("/"));
-			pushArg(Q("-f"));
-			pushArg(Q("/f"));
-			pushArg(Q("--f"));
-			pushArg(Q("//f"));
+		args.push_back(Q("x"));
+		args.push_back(Q("1"));
+		args.push_back(Q("2"));
+		Dump(expected, 1);
+		Dump(expected, 2);
 
-			auto parseContext = opts.CreateParseContext(args.begin(), args.end());
-			parseContext.Run();
-		};
+		args.push_back(Q("x"));
+		args.push_back(Q("3"));
+		args.push_back(Q("y"));
+		Dump(expected, 3);
+		Dump(expected, L"y");
 
-		testStyle(KeywordStyle::Exact, Q(""), Q(""));
-		testStyle(KeywordStyle::Exact, Q("f"), Q("f"));
-		testStyle(KeywordStyle::Exact, Q("-f"), Q("-f"));
-		testStyle(KeywordStyle::Exact, Q("--f"), Q("--f"));
-		testStyle(KeywordStyle::Exact, Q("/f"), Q("/f"));
-		testStyle(KeywordStyle::Exact, Q("//f"), Q("//f"));
-		testStyle(KeywordStyle::Exact, Q("foo"), Q("foo"));
-		testStyle(KeywordStyle::Exact, Q("-foo"), Q("-foo"));
-		testStyle(KeywordStyle::Exact, Q("--foo"), Q("--foo"));
-		testStyle(KeywordStyle::Exact, Q("---foo"), Q("---foo"));
-		testStyle(KeywordStyle::Exact, Q("/foo"), Q("/foo"));
-		testStyle(KeywordStyle::Exact, Q("//foo"), Q("//foo"));
+		args.push_back(Q("x"));
+		args.push_back(Q("z"));
+		Dump(expected, L"z");
 
-		testStyle(KeywordStyle::Gnu, Q(""), Q(""));
-		testStyle(KeywordStyle::Gnu, Q("f"), Q("-f"));
-		testStyle(KeywordStyle::Gnu, Q("-f"), Q("-f"));
-		testStyle(KeywordStyle::Gnu, Q("--f"), Q("--f"));
-		testStyle(KeywordStyle::Gnu, Q("/f"), Q("--/f"));
-		testStyle(KeywordStyle::Gnu, Q("//f"), Q("--//f"));
-		testStyle(KeywordStyle::Gnu, Q("foo"), Q("--foo"));
-		testStyle(KeywordStyle::Gnu, Q("-foo"), Q("--foo"));
-		testStyle(KeywordStyle::Gnu, Q("--foo"), Q("--foo"));
-		testStyle(KeywordStyle::Gnu, Q("---foo"), Q("---foo"));
-		testStyle(KeywordStyle::Gnu, Q("/foo"), Q("--/foo"));
-		testStyle(KeywordStyle::Gnu, Q("//foo"), Q("--//foo"));
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
 
-		testStyle(KeywordStyle::Windows, Q(""), Q(""));
-		testStyle(KeywordStyle::Windows, Q("f"), Q("/f"));
-		testStyle(KeywordStyle::Windows, Q("-f"), Q("/-f"));
-		testStyle(KeywordStyle::Windows, Q("--f"), Q("/--f"));
-		testStyle(KeywordStyle::Windows, Q("/f"), Q("/f"));
-		testStyle(KeywordStyle::Windows, Q("//f"), Q("//f"));
-		testStyle(KeywordStyle::Windows, Q("foo"), Q("/foo"));
-		testStyle(KeywordStyle::Windows, Q("-foo"), Q("/-foo"));
-		testStyle(KeywordStyle::Windows, Q("--foo"), Q("/--foo"));
-		testStyle(KeywordStyle::Windows, Q("---foo"), Q("/---foo"));
-		testStyle(KeywordStyle::Windows, Q("/foo"), Q("/foo"));
-		testStyle(KeywordStyle::Windows, Q("//foo"), Q("//foo"));
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+		if (Helper::conversions != 4) {
+			FAIL;
+		}
 	}
 
 
-	static void TestMatchFlags1 ()
+	static void TestOverloadTree ()
 	{
-		OptionsConfig config;
-		config.keywordStyle = KeywordStyle::Exact;
-		config.matchFlags = MatchFlags::IgnoreAsciiCase;
-		Opts opts(config);
+		typedef TestLazyHelper Helper;
 
-		auto addOption = [&] (char const * name) {
-			opts.AddOption(Q(name), nop);
-		};
+		std::wstringstream ss;
 
-		auto dupOption = [&] (char const * name, char const * existingName) {
-			try {
-				addOption(name);
-			}
-			catch (lambda_options::OptionConflictException<Char> const & e) {
-				if (e.conflictingNames.first != Q(name)) {
-					FAIL;
-				}
-				if (e.conflictingNames.second != Q(existingName)) {
-					FAIL;
-				}
-				return;
-			}
-			FAIL;
-		};
+		Helper::conversions = 0;
 
-		addOption("abc");
-		dupOption("Abc", "abc");
-		dupOption("aBc", "abc");
-		dupOption("abC", "abc");
-		dupOption("aBC", "abc");
-		dupOption("AbC", "abc");
-		dupOption("ABc", "abc");
-		dupOption("ABC", "abc");
+		Opts opts(testConfig);
+		opts.AddOption(Q("p"), [&] (Helper a) {
+			Dump(ss, a.value);
+		});
+		opts.AddOption(Q("p"), [&] (Helper a, int b, int c) {
+			if (c < 0) {
+				throw lambda_options::RejectArgumentException<Char>(2, Q(""));
+			}
+			Dump(ss, a.value);
+			Dump(ss, b);
+			Dump(ss, c);
+		});
+		opts.AddOption(Q("p"), [&] (Helper a, int b) {
+			Dump(ss, a.value);
+			Dump(ss, b);
+		});
+		opts.AddOption(Q("p"), [&] (Helper a, String b) {
+			Dump(ss, a.value);
+			Dump(ss, b);
+		});
+		opts.AddOption(Q("p"), [&] (String a) {
+			Dump(ss, a);
+		});
+		opts.AddOption(Keyword(Q("b")), [&] (int a, int b) {
+			Dump(ss, a + b);
+		});
+		opts.AddOption(Keyword(Q("a"), Q("b")), [&] (int a) {
+			Dump(ss, -a);
+		});
+		opts.AddOption(empty, [&] (String a) {
+			Dump(ss, a);
+		});
 
-		addOption("FOO");
-		dupOption("foo", "FOO");
+		std::vector<String> args;
+		std::wstringstream expected;
 
-		addOption("BaR");
-		dupOption("bAr", "BaR");
-	}
+		args.push_back(Q("p"));
+		args.push_back(Q("1"));
+		args.push_back(Q("2"));
+		args.push_back(Q("3"));
+		Dump(expected, 1);
+		Dump(expected, 2);
+		Dump(expected, 3);
 
+		args.push_back(Q("p"));
+		args.push_back(Q("4"));
+		args.push_back(Q("5"));
+		args.push_back(Q("-6"));
+		Dump(expected, 4);
+		Dump(expected, 5);
+		Dump(expected, L"-6");
 
-	static void TestMatchFlags2 ()
-	{
-		std::wstringstream ss;
-		
-		OptionsConfig config;
-		config.keywordStyle = KeywordStyle::Exact;
-		config.matchFlags = MatchFlags::RelaxedDashes;
-		Opts opts(config);
+		args.push_back(Q("p"));
+		args.push_back(Q("7"));
+		args.push_back(Q("q"));
+		Dump(expected, 7);
+		Dump(expected, L"q");
 
-		opts.AddOption(empty, [&] (String str) {
-			Dump(ss, str);
-		});
+		args.push_back(Q("p"));
+		args.push_back(Q("z"));
+		Dump(expected, L"z");
 
-		auto addOption = [&] (char const * name) {
-			opts.AddOption(Q(name), [&, name] () {
-				DumpMemo(ss, L(name));
-			});
-		};
+		args.push_back(Q("b"));
+		args.push_back(Q("1"));
+		args.push_back(Q("2"));
+		Dump(expected, 3);
 
-		auto dupOption = [&] (char const * name, char const * existingName) {
-			try {
-				addOption(name);
-			}
-			catch (lambda_options::OptionConflictException<Char> const & e) {
-				if (e.conflictingNames.first != Q(name)) {
-					FAIL;
-				}
-				if (e.conflictingNames.second != Q(existingName)) {
-					FAIL;
-				}
-				return;
-			}
+		args.push_back(Q("a"));
+		args.push_back(Q("1"));
+		args.push_back(Q("2"));
+		Dump(expected, -1);
+		Dump(expected, L"2");
+
+		args.push_back(Q("p"));
+		args.push_back(Q("8"));
+		Dump(expected, 8);
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+
+		if (ss.str() != expected.str()) {
 			FAIL;
-		};
-		
-		addOption("a");
-		addOption("-a");
-		addOption("--a");
-		addOption("---a");
+		}
+		if (Helper::conversions != 6) {
+			FAIL;
+		}
+	}
 
-		dupOption("a", "a");
-		dupOption("a-", "a");
-		dupOption("a--", "a");
-		dupOption("a---", "a");
-		dupOption("-a", "-a");
-		dupOption("--a", "--a");
-		dupOption("---a", "---a");
 
-		addOption("aa");
-		addOption("-aa");
-		addOption("--aa");
-		addOption("---aa");
+	static void TestTokenTraits ()
+	{
+		using lambda_options::TokenTraits;
+		size_t const unbounded = lambda_options::UnboundedTokens;
+
+		if (TokenTraits<Char, int>::MinTokens != 1 || TokenTraits<Char, int>::MaxTokens != 1) {
+			FAIL;
+		}
+		if (TokenTraits<Char, std::vector<int>>::MinTokens != 0 || TokenTraits<Char, std::vector<int>>::MaxTokens != unbounded) {
+			FAIL;
+		}
+		if (TokenTraits<Char, std::array<float, 3>>::MinTokens != 3 || TokenTraits<Char, std::array<float, 3>>::MaxTokens != 3) {
+			FAIL;
+		}
+		if (TokenTraits<Char, std::pair<int, std::vector<int>>>::MinTokens != 1 || TokenTraits<Char, std::pair<int, std::vector<int>>>::MaxTokens != unbounded) {
+			FAIL;
+		}
+		if (TokenTraits<Char, lambda_options::ParseState<Char>>::MinTokens != 0 || TokenTraits<Char, lambda_options::ParseState<Char>>::MaxTokens != unbounded) {
+			FAIL;
+		}
+		if (TokenTraits<Char, lambda_options::Lazy<TestRangeHelper>>::MinTokens != 2) {
+			FAIL;
+		}
+		if (TokenTraits<Char, unsigned int>::CanStartWith(Q("-1")) || !TokenTraits<Char, int>::CanStartWith(Q("-1"))) {
+			FAIL;
+		}
+		if (TokenTraits<Char, double>::CanStartWith(Q("x")) || !TokenTraits<Char, String>::CanStartWith(Q("x"))) {
+			FAIL;
+		}
+
+		std::wstringstream ss;
+
+		TestRangeHelper::parses = 0;
+
+		Opts opts(testConfig);
+		opts.AddOption(Q("r"), [&] (TestRangeHelper x) {
+			Dump(ss, x.low);
+			Dump(ss, x.high);
+		});
+		opts.AddOption(Q("r"), [&] (String x) {
+			Dump(ss, x);
+		});
+		opts.AddOption(Q("u"), [&] (unsigned int x) {
+			Dump(ss, x);
+		});
+		opts.AddOption(Q("u"), [&] (int x) {
+			Dump(ss, -x);
+		});
 
-		dupOption("a-a", "aa");
-		dupOption("a--a", "aa");
-		dupOption("a---a", "aa");
-		dupOption("a-a-", "aa");
-		dupOption("-a-a", "-aa");
-		dupOption("-a-a-", "-aa");
-		dupOption("--a--a--", "--aa");
-		dupOption("---a---a---", "---aa");
-		
-		std::wstringstream expected;
 		std::vector<String> args;
+		std::wstringstream expected;
 
-		auto yesArg = [&] (char const * cstrIn, char const * cstrExpected) {
-			args.push_back(Q(cstrIn));
-			DumpMemo(expected, L(cstrExpected));
-		};
+		args.push_back(Q("r"));
+		args.push_back(Q("x"));
+		Dump(expected, L"x");
 
-		auto badArg = [&] (char const * arg) {
-			args.push_back(Q(arg));
-			Dump(expected, arg);
-		};
+		args.push_back(Q("r"));
+		args.push_back(Q("1"));
+		args.push_back(Q("2"));
+		Dump(expected, 1);
+		Dump(expected, 2);
 
-		yesArg("a", "a");
-		yesArg("-a", "-a");
-		yesArg("--a", "--a");
-		yesArg("---a", "---a");
-		yesArg("a-", "a");
-		yesArg("a-a", "aa");
-		yesArg("a--a", "aa");
-		yesArg("a---a", "aa");
-		yesArg("-a-", "-a");
-		yesArg("-a--", "-a");
-		yesArg("-a---", "-a");
-		yesArg("--a-", "--a");
-		yesArg("--a--", "--a");
-		yesArg("--a---", "--a");
-		yesArg("---a-", "---a");
-		yesArg("---a--", "---a");
-		yesArg("---a---", "---a");
-		yesArg("-aa-", "-aa");
-		yesArg("-aa--", "-aa");
-		yesArg("-aa---", "-aa");
-		yesArg("-a-a-", "-aa");
-		yesArg("-a-a--", "-aa");
-		yesArg("-a-a---", "-aa");
-		yesArg("-a--a-", "-aa");
-		yesArg("-a--a--", "-aa");
-		yesArg("-a--a---", "-aa");
-		yesArg("--aa-", "--aa");
-		yesArg("--aa--", "--aa");
-		yesArg("--aa---", "--aa");
-		yesArg("---aa-", "---aa");
-		yesArg("---aa--", "---aa");
-		yesArg("---aa---", "---aa");
-		yesArg("--a-a-", "--aa");
-		yesArg("--a-a--", "--aa");
-		yesArg("--a-a---", "--aa");
-		yesArg("---a-a-", "---aa");
-		yesArg("---a-a--", "---aa");
-		yesArg("---a-a---", "---aa");
-		yesArg("--a--a-", "--aa");
-		yesArg("--a--a--", "--aa");
-		yesArg("--a--a---", "--aa");
-		yesArg("---a--a-", "---aa");
-		yesArg("---a--a--", "---aa");
-		yesArg("---a--a---", "---aa");
-		yesArg("-a---a-", "-aa");
-		yesArg("-a---a--", "-aa");
-		yesArg("-a---a---", "-aa");
-		yesArg("--a---a-", "--aa");
-		yesArg("--a---a--", "--aa");
-		yesArg("--a---a---", "--aa");
-		yesArg("---a---a-", "---aa");
-		yesArg("---a---a--", "---aa");
-		yesArg("---a---a---", "---aa");
+		args.push_back(Q("u"));
+		args.push_back(Q("-3"));
+		Dump(expected, 3);
 
-		badArg("");
-		badArg("A");
-		badArg("_a");
-		badArg("a_");
+		args.push_back(Q("r"));
+		args.push_back(Q("4"));
+		Dump(expected, L"4");
 
 		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
 		parseContext.Run();
-		
-		auto const ssStr = ss.str();
-		auto const expectedStr = expected.str();
-		if (ssStr != expectedStr) {
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+		if (TestRangeHelper::parses != 1) {
 			FAIL;
 		}
 	}
 
 
-	static void TestMatchFlags3 ()
+	static void TestOverloadProfile ()
 	{
 		std::wstringstream ss;
-		
-		OptionsConfig config;
-		config.keywordStyle = KeywordStyle::Exact;
-		config.matchFlags = MatchFlags::RelaxedUnderscores;
-		Opts opts(config);
-
-		opts.AddOption(empty, [&] (String str) {
-			Dump(ss, str);
-		});
 
-		auto addOption = [&] (char const * name) {
-			opts.AddOption(Q(name), [&, name] () {
-				DumpMemo(ss, L(name));
+		auto addOptions = [&] (Opts & opts) {
+			opts.AddOption(Q("a"), [&] () {
+				Dump(ss, L"a");
+			});
+			opts.AddOption(Q("b"), [&] (int x) {
+				Dump(ss, x);
+			});
+			opts.AddOption(Q("b"), [&] (String x) {
+				Dump(ss, x);
+			});
+			opts.AddOption(Keyword(Q("c"), Q("d")), [&] () {
+				Dump(ss, L"cd");
+			});
+			opts.AddOption(Q("d"), [&] (int x) {
+				Dump(ss, -x);
+			});
+			opts.AddOption(empty, [&] (String x) {
+				Dump(ss, x);
 			});
 		};
 
-		auto dupOption = [&] (char const * name, char const * existingName) {
-			try {
-				addOption(name);
-			}
-			catch (lambda_options::OptionConflictException<Char> const & e) {
-				if (e.conflictingNames.first != Q(name)) {
-					FAIL;
+		std::vector<String> args;
+		args.push_back(Q("b"));
+		args.push_back(Q("1"));
+		args.push_back(Q("d"));
+		args.push_back(Q("2"));
+		args.push_back(Q("b"));
+		args.push_back(Q("x"));
+		args.push_back(Q("d"));
+		args.push_back(Q("e"));
+		args.push_back(Q("b"));
+		args.push_back(Q("3"));
+		args.push_back(Q("a"));
+
+		std::wstringstream expected;
+		Dump(expected, 1);
+		Dump(expected, -2);
+		Dump(expected, L"x");
+		Dump(expected, L"cd");
+		Dump(expected, L"e");
+		Dump(expected, 3);
+		Dump(expected, L"a");
+
+		Opts opts(testConfig);
+		addOptions(opts);
+		opts.CreateParseContext(args.begin(), args.end()).Run();
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+
+		size_t const expectedHits[] = { 1, 2, 1, 1, 1, 1 };
+		std::vector<size_t> hits = opts.OverloadHits();
+		if (!Equal(hits, expectedHits)) {
+			FAIL;
+		}
+
+		Opts profiled(testConfig);
+		addOptions(profiled);
+		profiled.LoadOverloadProfile(hits);
+		ss.str(L"");
+		profiled.CreateParseContext(args.begin(), args.end()).Run();
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+
+		OptionsConfig config = testConfig;
+		config.adaptiveOrdering = true;
+		Opts adaptive(config);
+		addOptions(adaptive);
+		ss.str(L"");
+		adaptive.CreateParseContext(args.begin(), args.end()).Run();
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+
+
+	static void TestParseLimits ()
+	{
+		int calls = 0;
+
+		Opts opts(testConfig);
+		opts.AddOption(Q("x"), [&] (int, int) {
+			++calls;
+		});
+
+		std::vector<String> args;
+		for (int i = 0; i < 10; ++i) {
+			args.push_back(Q("x"));
+			args.push_back(Q("1"));
+			args.push_back(Q("2"));
+		}
+
+		auto runWith = [&] (lambda_options::ParseLimits const & limits) {
+			calls = 0;
+			auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+			parseContext.SetLimits(limits);
+			try {
+				parseContext.Run();
+			}
+			catch (lambda_options::ParseFailedException<Char> const & e) {
+				return e.failure;
+			}
+			return lambda_options::ParseFailure::BadArguments;
+		};
+
+		lambda_options::ParseLimits limits;
+		limits.maxSteps = 1000;
+		runWith(limits);
+		if (calls != 10) {
+			FAIL;
+		}
+
+		limits.maxSteps = 20;
+		if (runWith(limits) != lambda_options::ParseFailure::WorkLimitExceeded) {
+			FAIL;
+		}
+		if (calls == 0 || calls >= 10) {
+			FAIL;
+		}
+
+		// Each run of one context starts with a fresh step count, and a run that hit the limit does not fail later runs.
+		std::vector<String> shortArgs;
+		shortArgs.push_back(Q("x"));
+		shortArgs.push_back(Q("1"));
+		shortArgs.push_back(Q("2"));
+		auto parseContext = opts.CreateParseContext(shortArgs.begin(), shortArgs.end());
+		lambda_options::ParseFailedException<Char> e;
+		limits.maxSteps = 10;
+		parseContext.SetLimits(limits);
+		for (int i = 0; i < 3; ++i) {
+			if (!parseContext.Run(e)) {
+				FAIL;
+			}
+		}
+		limits.maxSteps = 1;
+		parseContext.SetLimits(limits);
+		if (parseContext.Run(e) || e.failure != lambda_options::ParseFailure::WorkLimitExceeded) {
+			FAIL;
+		}
+		limits.maxSteps = 10;
+		parseContext.SetLimits(limits);
+		if (!parseContext.Run(e)) {
+			FAIL;
+		}
+
+		std::atomic<bool> cancel(false);
+		limits = lambda_options::ParseLimits();
+		limits.cancel = &cancel;
+		opts.AddOption(Q("stop"), [&] () {
+			cancel = true;
+		});
+		args.insert(args.begin() + 6, Q("stop"));
+		if (runWith(limits) != lambda_options::ParseFailure::Cancelled) {
+			FAIL;
+		}
+		if (calls != 2) {
+			FAIL;
+		}
+	}
+
+
+	static void TestDeterministic ()
+	{
+		OptionsConfig config = testConfig;
+		config.deterministic = true;
+
+		std::wstringstream ss;
+
+		Opts opts(config);
+		opts.AddOption(Keyword(Q("a"), Q("b")), [&] (int x) {
+			Dump(ss, x);
+		});
+		opts.AddOption(Q("c"), [&] () {
+			Dump(ss, L"c");
+		});
+		opts.AddOption(empty, [&] (String x) {
+			Dump(ss, x);
+		});
+		opts.AddOption(Keyword().Prefix(Q("-W")), [&] (String warning) {
+			Dump(ss, warning);
+		});
+
+		auto ambiguous = [&] (std::function<void()> const & addOption, char const * name1, char const * name2) {
+			try {
+				addOption();
+			}
+			catch (lambda_options::AmbiguousOptionException<Char> const & e) {
+				if (e.ambiguousNames.first != Q(name1)) {
+					FAIL;
 				}
-				if (e.conflictingNames.second != Q(existingName)) {
+				if (e.ambiguousNames.second != Q(name2)) {
 					FAIL;
 				}
 				return;
 			}
 			FAIL;
 		};
-		
-		addOption("a");
-		addOption("-a");
-		addOption("--a");
-		addOption("---a");
+		ambiguous([&] () { opts.AddOption(Q("a"), [] (String) {}); }, "a", "a");
+		ambiguous([&] () { opts.AddOption(Keyword(Q("d"), Q("b")), [] () {}); }, "b", "b");
+		ambiguous([&] () { opts.AddOption(Q("c"), [] (int) {}); }, "c", "c");
+		ambiguous([&] () { opts.AddOption(empty, [] (int) {}); }, "", "");
+		ambiguous([&] () { opts.AddOption(Keyword().Prefix(Q("-Wl")), [] (int) {}); }, "-Wl", "-W");
+		ambiguous([&] () { opts.AddOption(Keyword().Prefix(Q("-")), [] (int) {}); }, "-", "-W");
+		ambiguous([&] () { opts.AddOption(Q("-Wall"), [] () {}); }, "-Wall", "-W");
 
-		dupOption("a", "a");
-		dupOption("a_", "a");
-		dupOption("a__", "a");
-		dupOption("a___", "a");
-		dupOption("-a", "-a");
-		dupOption("--a", "--a");
-		dupOption("---a", "---a");
+		std::vector<String> args;
+		std::wstringstream expected;
 
-		addOption("aa");
-		addOption("-aa");
-		addOption("--aa");
-		addOption("---aa");
+		args.push_back(Q("b"));
+		args.push_back(Q("1"));
+		Dump(expected, 1);
+
+		args.push_back(Q("c"));
+		Dump(expected, L"c");
+
+		args.push_back(Q("d"));
+		Dump(expected, L"d");
+
+		args.push_back(Q("-Wlx"));
+		Dump(expected, L"lx");
+
+		args.push_back(Q("a"));
+		args.push_back(Q("x"));
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		try {
+			parseContext.Run();
+			FAIL;
+		}
+		catch (lambda_options::ParseFailedException<Char> const & e) {
+			if (e.beginIndex != 5) {
+				FAIL;
+			}
+		}
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+
+
+#ifdef LAMBDA_OPTIONS_FILE_MAPPING
+	static std::string TempPath (char const * name)
+	{
+		char const * dir = std::getenv("TMPDIR");
+		if (dir == nullptr) {
+			dir = std::getenv("TEMP");
+		}
+		std::string path = (dir == nullptr) ? "/tmp" : dir;
+		if (path.back() != '/' && path.back() != '\\') {
+			path += '/';
+		}
+		return path + name;
+	}
+
+	static void TestFileContents ()
+	{
+		std::string const tempPath = TempPath("lambda-options-test-file.txt");
+		char const * const path = tempPath.c_str();
+		std::string const contents = "file\ncontents";
+		{
+			std::FILE * file = std::fopen(path, "wb");
+			if (file == nullptr) {
+				FAIL;
+			}
+			std::fwrite(contents.data(), 1, contents.size(), file);
+			std::fclose(file);
+		}
+
+		std::vector<std::string> read;
+
+		Opts opts(testConfig);
+		opts.AddOption(Q("file"), [&] (lambda_options::FileContents x) {
+			read.push_back(std::string(x.begin(), x.end()));
+		});
+		opts.AddOption(Q("file"), [&] (String) {
+			read.push_back("<missing>");
+		});
 
-		dupOption("a_a", "aa");
-		dupOption("a__a", "aa");
-		dupOption("a___a", "aa");
-		dupOption("a_a_", "aa");
-		dupOption("-a_a", "-aa");
-		dupOption("-a_a_", "-aa");
-		dupOption("--a__a__", "--aa");
-		dupOption("---a___a___", "---aa");
-		
-		std::wstringstream expected;
 		std::vector<String> args;
+		args.push_back(Q("file"));
+		args.push_back(Q("@") + Q(path));
+		args.push_back(Q("file"));
+		args.push_back(Q(path));
+		args.push_back(Q("file"));
+		args.push_back(Q("@lambda-options-missing-file.txt"));
 
-		auto yesArg = [&] (char const * cstrIn, char const * cstrExpected) {
-			args.push_back(Q(cstrIn));
-			DumpMemo(expected, L(cstrExpected));
+		{
+			auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+			parseContext.Run();
+		}
+		std::remove(path);
+
+		std::string const expected[] = { contents, contents, "<missing>" };
+		if (!Equal(read, expected)) {
+			FAIL;
+		}
+	}
+#endif
+
+
+	static void TestHelpDescription ()
+	{
+		Opts opts(testConfig);
+
+		Keyword kwFoo(Q("foo"));
+		kwFoo.text = Q("Foo does shtuff.");
+		opts.AddOption(kwFoo, nop);
+
+		Keyword kwBar(Q("bar"), Q('b'));
+		kwBar.text = Q("Bar does even moare shtuff!!!");
+		opts.AddOption(kwBar, nop);
+
+		Keyword kwRofl(Q("foflcopter"));
+		kwRofl.text = Q("0123456789 01234567890123456789 012345678901234567890123456789 0123456789012345678901234567890123456789");
+		opts.AddOption(kwRofl, nop);
+
+		FormattingConfig config;
+		config.maxWidth = 0;
+		String desc = opts.HelpDescription(config);
+
+		auto printString = [] (String const & str) {
+			std::cout << "\n<String>\n";
+			for (Char c : str) {
+				std::cout << static_cast<char>(c);
+			}
+			std::cout << "\n</String>\n";
 		};
 
-		auto badArg = [&] (char const * arg) {
-			args.push_back(Q(arg));
-			Dump(expected, arg);
+		printString(desc);
+	}
+
+	static void TestHelpGroups ()
+	{
+		Opts opts(testConfig);
+
+		Keyword kwFoo(Q("foo"));
+		kwFoo.helpGroup = Q("cake");
+		opts.AddOption(kwFoo, nop);
+
+		Keyword kwBar(Q("bar"));
+		kwBar.helpGroup = Q("lie");
+		opts.AddOption(kwBar, nop);
+
+		Keyword kwBaz(Q("baz"));
+		kwBaz.helpGroup = Q("cake");
+		opts.AddOption(kwBaz, nop);
+
+		auto printString = [] (String const & str) {
+			std::cout << "\n<String>\n";
+			for (Char c : str) {
+				std::cout << static_cast<char>(c);
+			}
+			std::cout << "\n</String>\n";
 		};
 
-		yesArg("a", "a");
-		yesArg("-a", "-a");
-		yesArg("--a", "--a");
-		yesArg("---a", "---a");
-		yesArg("a_", "a");
-		yesArg("a_a", "aa");
-		yesArg("a__a", "aa");
-		yesArg("a___a", "aa");
-		yesArg("-a_", "-a");
-		yesArg("-a__", "-a");
-		yesArg("-a___", "-a");
-		yesArg("--a_", "--a");
-		yesArg("--a__", "--a");
-		yesArg("--a___", "--a");
-		yesArg("---a_", "---a");
-		yesArg("---a__", "---a");
-		yesArg("---a___", "---a");
-		yesArg("-aa_", "-aa");
-		yesArg("-aa__", "-aa");
-		yesArg("-aa___", "-aa");
-		yesArg("-a_a_", "-aa");
-		yesArg("-a_a__", "-aa");
-		yesArg("-a_a___", "-aa");
-		yesArg("-a__a_", "-aa");
-		yesArg("-a__a__", "-aa");
-		yesArg("-a__a___", "-aa");
-		yesArg("--aa_", "--aa");
-		yesArg("--aa__", "--aa");
+		{
+			String desc = opts.HelpDescription();
+			printString(desc);
+		}
+		opts.SetHelpGroupPriority(Q("cake"), 0);
+		opts.SetHelpGroupPriority(Q("lie"), 1);
+		{
+			String desc = opts.HelpDescription();
+			printString(desc);
+		}
+		opts.SetHelpGroupPriority(Q("cake"), 10);
+		opts.SetHelpGroupPriority(Q("lie"), 5);
+		{
+			FormattingConfig config;
+			config.helpGroupFilter.push_back(Q("cake"));
+			String desc = opts.HelpDescription(config);
+			printString(desc);
+		}
+		{
+			FormattingConfig config;
+			config.helpGroupFilter.push_back(Q("cake"));
+			config.helpGroupFilter.push_back(Q("lie"));
+			String desc = opts.HelpDescription(config);
+			printString(desc);
+		}
+		{
+			FormattingConfig config;
+			config.helpGroupFilter.push_back(Q("lie"));
+			config.helpGroupFilter.push_back(Q("cake"));
+			String desc = opts.HelpDescription(config);
+			printString(desc);
+		}
+		{
+			FormattingConfig config;
+			config.helpGroupFilter.push_back(Q("where"));
+			config.helpGroupFilter.push_back(Q("lie"));
+			config.helpGroupFilter.push_back(Q("waldo"));
+			String desc = opts.HelpDescription(config);
+			printString(desc);
+		}
+	}
+
+
+	static void TestKeywordStyle ()
+	{
+		static_assert(KeywordStyle::Default == KeywordStyle::Gnu, "whoops");
+
+		auto testStyle = [&] (KeywordStyle style, String const & inputName, String const expectedName) {
+			std::wstringstream ss;
+
+			OptionsConfig config;
+			config.keywordStyle = style;
+			config.matchFlags = MatchFlags::Empty;
+			Opts opts(config);
+
+			opts.AddOption(inputName, [&] () {
+				DumpMemo(ss, L(inputName));
+			});
+			opts.AddOption(empty, [&] (String s) {
+				Dump(ss, s);
+			});
+
+			std::vector<String> args;
+			std::wstringstream expected;
+
+			auto pushArg = [&] (String const & arg) {
+				args.push_back(arg);
+				if (arg == expectedName) {
+					DumpMemo(expected, L(inputName));
+				}
+				else {
+					Dump(expected, arg);
+				}
+			};
+
+			pushArg(Q("foo"));
+			pushArg(Q("-foo"));
+			pushArg(Q("--foo"));
+			pushArg(Q("---foo"));
+			pushArg(Q("/foo"));
+			pushArg(Q("//foo"));
+			pushArg(Q(""));
+			pushArg(Q("f"));
+			pushArg(Q("-"));
+			pushArg(Q("/"));
+			pushArg(Q("-f"));
+			pushArg(Q("/f"));
+			pushArg(Q("--f"));
+			pushArg(Q("//f"));
+
+			auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+			parseContext.Run();
+		};
+
+		testStyle(KeywordStyle::Exact, Q(""), Q(""));
+		testStyle(KeywordStyle::Exact, Q("f"), Q("f"));
+		testStyle(KeywordStyle::Exact, Q("-f"), Q("-f"));
+		testStyle(KeywordStyle::Exact, Q("--f"), Q("--f"));
+		testStyle(KeywordStyle::Exact, Q("/f"), Q("/f"));
+		testStyle(KeywordStyle::Exact, Q("//f"), Q("//f"));
+		testStyle(KeywordStyle::Exact, Q("foo"), Q("foo"));
+		testStyle(KeywordStyle::Exact, Q("-foo"), Q("-foo"));
+		testStyle(KeywordStyle::Exact, Q("--foo"), Q("--foo"));
+		testStyle(KeywordStyle::Exact, Q("---foo"), Q("---foo"));
+		testStyle(KeywordStyle::Exact, Q("/foo"), Q("/foo"));
+		testStyle(KeywordStyle::Exact, Q("//foo"), Q("//foo"));
+
+		testStyle(KeywordStyle::Gnu, Q(""), Q(""));
+		testStyle(KeywordStyle::Gnu, Q("f"), Q("-f"));
+		testStyle(KeywordStyle::Gnu, Q("-f"), Q("-f"));
+		testStyle(KeywordStyle::Gnu, Q("--f"), Q("--f"));
+		testStyle(KeywordStyle::Gnu, Q("/f"), Q("--/f"));
+		testStyle(KeywordStyle::Gnu, Q("//f"), Q("--//f"));
+		testStyle(KeywordStyle::Gnu, Q("foo"), Q("--foo"));
+		testStyle(KeywordStyle::Gnu, Q("-foo"), Q("--foo"));
+		testStyle(KeywordStyle::Gnu, Q("--foo"), Q("--foo"));
+		testStyle(KeywordStyle::Gnu, Q("---foo"), Q("---foo"));
+		testStyle(KeywordStyle::Gnu, Q("/foo"), Q("--/foo"));
+		testStyle(KeywordStyle::Gnu, Q("//foo"), Q("--//foo"));
+
+		testStyle(KeywordStyle::Windows, Q(""), Q(""));
+		testStyle(KeywordStyle::Windows, Q("f"), Q("/f"));
+		testStyle(KeywordStyle::Windows, Q("-f"), Q("/-f"));
+		testStyle(KeywordStyle::Windows, Q("--f"), Q("/--f"));
+		testStyle(KeywordStyle::Windows, Q("/f"), Q("/f"));
+		testStyle(KeywordStyle::Windows, Q("//f"), Q("//f"));
+		testStyle(KeywordStyle::Windows, Q("foo"), Q("/foo"));
+		testStyle(KeywordStyle::Windows, Q("-foo"), Q("/-foo"));
+		testStyle(KeywordStyle::Windows, Q("--foo"), Q("/--foo"));
+		testStyle(KeywordStyle::Windows, Q("---foo"), Q("/---foo"));
+		testStyle(KeywordStyle::Windows, Q("/foo"), Q("/foo"));
+		testStyle(KeywordStyle::Windows, Q("//foo"), Q("//foo"));
+	}
+
+
+	static void TestMatchFlags1 ()
+	{
+		OptionsConfig config;
+		config.keywordStyle = KeywordStyle::Exact;
+		config.matchFlags = MatchFlags::IgnoreAsciiCase;
+		Opts opts(config);
+
+		auto addOption = [&] (char const * name) {
+			opts.AddOption(Q(name), nop);
+		};
+
+		auto dupOption = [&] (char const * name, char const * existingName) {
+			try {
+				addOption(name);
+			}
+			catch (lambda_options::OptionConflictException<Char> const & e) {
+				if (e.conflictingNames.first != Q(name)) {
+					FAIL;
+				}
+				if (e.conflictingNames.second != Q(existingName)) {
+					FAIL;
+				}
+				return;
+			}
+			FAIL;
+		};
+
+		addOption("abc");
+		dupOption("Abc", "abc");
+		dupOption("aBc", "abc");
+		dupOption("abC", "abc");
+		dupOption("aBC", "abc");
+		dupOption("AbC", "abc");
+		dupOption("ABc", "abc");
+		dupOption("ABC", "abc");
+
+		addOption("FOO");
+		dupOption("foo", "FOO");
+
+		addOption("BaR");
+		dupOption("bAr", "BaR");
+	}
+
+
+	static void TestMatchFlags2 ()
+	{
+		std::wstringstream ss;
+		
+		OptionsConfig config;
+		config.keywordStyle = KeywordStyle::Exact;
+		config.matchFlags = MatchFlags::RelaxedDashes;
+		Opts opts(config);
+
+		opts.AddOption(empty, [&] (String str) {
+			Dump(ss, str);
+		});
+
+		auto addOption = [&] (char const * name) {
+			opts.AddOption(Q(name), [&, name] () {
+				DumpMemo(ss, L(name));
+			});
+		};
+
+		auto dupOption = [&] (char const * name, char const * existingName) {
+			try {
+				addOption(name);
+			}
+			catch (lambda_options::OptionConflictException<Char> const & e) {
+				if (e.conflictingNames.first != Q(name)) {
+					FAIL;
+				}
+				if (e.conflictingNames.second != Q(existingName)) {
+					FAIL;
+				}
+				return;
+			}
+			FAIL;
+		};
+		
+		addOption("a");
+		addOption("-a");
+		addOption("--a");
+		addOption("---a");
+
+		dupOption("a", "a");
+		dupOption("a-", "a");
+		dupOption("a--", "a");
+		dupOption("a---", "a");
+		dupOption("-a", "-a");
+		dupOption("--a", "--a");
+		dupOption("---a", "---a");
+
+		addOption("aa");
+		addOption("-aa");
+		addOption("--aa");
+		addOption("---aa");
+
+		dupOption("a-a", "aa");
+		dupOption("a--a", "aa");
+		dupOption("a---a", "aa");
+		dupOption("a-a-", "aa");
+		dupOption("-a-a", "-aa");
+		dupOption("-a-a-", "-aa");
+		dupOption("--a--a--", "--aa");
+		dupOption("---a---a---", "---aa");
+		
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		auto yesArg = [&] (char const * cstrIn, char const * cstrExpected) {
+			args.push_back(Q(cstrIn));
+			DumpMemo(expected, L(cstrExpected));
+		};
+
+		auto badArg = [&] (char const * arg) {
+			args.push_back(Q(arg));
+			Dump(expected, arg);
+		};
+
+		yesArg("a", "a");
+		yesArg("-a", "-a");
+		yesArg("--a", "--a");
+		yesArg("---a", "---a");
+		yesArg("a-", "a");
+		yesArg("a-a", "aa");
+		yesArg("a--a", "aa");
+		yesArg("a---a", "aa");
+		yesArg("-a-", "-a");
+		yesArg("-a--", "-a");
+		yesArg("-a---", "-a");
+		yesArg("--a-", "--a");
+		yesArg("--a--", "--a");
+		yesArg("--a---", "--a");
+		yesArg("---a-", "---a");
+		yesArg("---a--", "---a");
+		yesArg("---a---", "---a");
+		yesArg("-aa-", "-aa");
+		yesArg("-aa--", "-aa");
+		yesArg("-aa---", "-aa");
+		yesArg("-a-a-", "-aa");
+		yesArg("-a-a--", "-aa");
+		yesArg("-a-a---", "-aa");
+		yesArg("-a--a-", "-aa");
+		yesArg("-a--a--", "-aa");
+		yesArg("-a--a---", "-aa");
+		yesArg("--aa-", "--aa");
+		yesArg("--aa--", "--aa");
+		yesArg("--aa---", "--aa");
+		yesArg("---aa-", "---aa");
+		yesArg("---aa--", "---aa");
+		yesArg("---aa---", "---aa");
+		yesArg("--a-a-", "--aa");
+		yesArg("--a-a--", "--aa");
+		yesArg("--a-a---", "--aa");
+		yesArg("---a-a-", "---aa");
+		yesArg("---a-a--", "---aa");
+		yesArg("---a-a---", "---aa");
+		yesArg("--a--a-", "--aa");
+		yesArg("--a--a--", "--aa");
+		yesArg("--a--a---", "--aa");
+		yesArg("---a--a-", "---aa");
+		yesArg("---a--a--", "---aa");
+		yesArg("---a--a---", "---aa");
+		yesArg("-a---a-", "-aa");
+		yesArg("-a---a--", "-aa");
+		yesArg("-a---a---", "-aa");
+		yesArg("--a---a-", "--aa");
+		yesArg("--a---a--", "--aa");
+		yesArg("--a---a---", "--aa");
+		yesArg("---a---a-", "---aa");
+		yesArg("---a---a--", "---aa");
+		yesArg("---a---a---", "---aa");
+
+		badArg("");
+		badArg("A");
+		badArg("_a");
+		badArg("a_");
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+		
+		auto const ssStr = ss.str();
+		auto const expectedStr = expected.str();
+		if (ssStr != expectedStr) {
+			FAIL;
+		}
+	}
+
+
+	static void TestMatchFlags3 ()
+	{
+		std::wstringstream ss;
+		
+		OptionsConfig config;
+		config.keywordStyle = KeywordStyle::Exact;
+		config.matchFlags = MatchFlags::RelaxedUnderscores;
+		Opts opts(config);
+
+		opts.AddOption(empty, [&] (String str) {
+			Dump(ss, str);
+		});
+
+		auto addOption = [&] (char const * name) {
+			opts.AddOption(Q(name), [&, name] () {
+				DumpMemo(ss, L(name));
+			});
+		};
+
+		auto dupOption = [&] (char const * name, char const * existingName) {
+			try {
+				addOption(name);
+			}
+			catch (lambda_options::OptionConflictException<Char> const & e) {
+				if (e.conflictingNames.first != Q(name)) {
+					FAIL;
+				}
+				if (e.conflictingNames.second != Q(existingName)) {
+					FAIL;
+				}
+				return;
+			}
+			FAIL;
+		};
+		
+		addOption("a");
+		addOption("-a");
+		addOption("--a");
+		addOption("---a");
+
+		dupOption("a", "a");
+		dupOption("a_", "a");
+		dupOption("a__", "a");
+		dupOption("a___", "a");
+		dupOption("-a", "-a");
+		dupOption("--a", "--a");
+		dupOption("---a", "---a");
+
+		addOption("aa");
+		addOption("-aa");
+		addOption("--aa");
+		addOption("---aa");
+
+		dupOption("a_a", "aa");
+		dupOption("a__a", "aa");
+		dupOption("a___a", "aa");
+		dupOption("a_a_", "aa");
+		dupOption("-a_a", "-aa");
+		dupOption("-a_a_", "-aa");
+		dupOption("--a__a__", "--aa");
+		dupOption("---a___a___", "---aa");
+		
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		auto yesArg = [&] (char const * cstrIn, char const * cstrExpected) {
+			args.push_back(Q(cstrIn));
+			DumpMemo(expected, L(cstrExpected));
+		};
+
+		auto badArg = [&] (char const * arg) {
+			args.push_back(Q(arg));
+			Dump(expected, arg);
+		};
+
+		yesArg("a", "a");
+		yesArg("-a", "-a");
+		yesArg("--a", "--a");
+		yesArg("---a", "---a");
+		yesArg("a_", "a");
+		yesArg("a_a", "aa");
+		yesArg("a__a", "aa");
+		yesArg("a___a", "aa");
+		yesArg("-a_", "-a");
+		yesArg("-a__", "-a");
+		yesArg("-a___", "-a");
+		yesArg("--a_", "--a");
+		yesArg("--a__", "--a");
+		yesArg("--a___", "--a");
+		yesArg("---a_", "---a");
+		yesArg("---a__", "---a");
+		yesArg("---a___", "---a");
+		yesArg("-aa_", "-aa");
+		yesArg("-aa__", "-aa");
+		yesArg("-aa___", "-aa");
+		yesArg("-a_a_", "-aa");
+		yesArg("-a_a__", "-aa");
+		yesArg("-a_a___", "-aa");
+		yesArg("-a__a_", "-aa");
+		yesArg("-a__a__", "-aa");
+		yesArg("-a__a___", "-aa");
+		yesArg("--aa_", "--aa");
+		yesArg("--aa__", "--aa");
 		yesArg("--aa___", "--aa");
 		yesArg("---aa_", "---aa");
 		yesArg("---aa__", "---aa");
@@ -1655,487 +2734,1456 @@ public:
 		yesArg("---a___a__", "---aa");
 		yesArg("---a___a___", "---aa");
 
-		yesArg("-_a", "-a");
-		yesArg("--__a", "--a");
-		yesArg("---___a", "---a");
+		yesArg("-_a", "-a");
+		yesArg("--__a", "--a");
+		yesArg("---___a", "---a");
+
+		badArg("");
+		badArg("A");
+		badArg("-a-");
+		badArg("_-a");
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+		
+		auto const ssStr = ss.str();
+		auto const expectedStr = expected.str();
+		if (ssStr != expectedStr) {
+			FAIL;
+		}
+	}
+
+
+	static void TestMatchFlags4 ()
+	{
+		OptionsConfig config;
+		config.keywordStyle = KeywordStyle::Exact;
+		config.matchFlags = MatchFlags::IgnoreAsciiCase | MatchFlags::RelaxedDashes | MatchFlags::RelaxedUnderscores;
+		Opts opts(config);
+
+		auto addOption = [&] (char const * name) {
+			opts.AddOption(Q(name), nop);
+		};
+
+		auto dupOption = [&] (char const * name, char const * existingName) {
+			try {
+				addOption(name);
+			}
+			catch (lambda_options::OptionConflictException<Char> const & e) {
+				if (e.conflictingNames.first != Q(name)) {
+					FAIL;
+				}
+				if (e.conflictingNames.second != Q(existingName)) {
+					FAIL;
+				}
+				return;
+			}
+			FAIL;
+		};
+
+		addOption("");
+		dupOption("_", "");
+		dupOption("_", "");
+		dupOption("_-", "");
+		dupOption("_-_", "");
+		dupOption("__", "");
+
+		addOption("-");
+		dupOption("-_", "-");
+		dupOption("-__--__--", "-");
+
+		addOption("a");
+		addOption("-a");
+		addOption("--A");
+		addOption("---a");
+
+		dupOption("a", "a");
+		dupOption("a_", "a");
+		dupOption("a__", "a");
+		dupOption("a___", "a");
+		dupOption("-a", "-a");
+		dupOption("--a", "--A");
+		dupOption("---a", "---a");
+		dupOption("-_A", "-a");
+		dupOption("--_A_", "--A");
+		dupOption("---A_", "---a");
+
+		addOption("aa");
+		addOption("-aa");
+		addOption("--aa");
+		addOption("---aa");
+
+		dupOption("AA", "aa");
+		dupOption("Aa", "aa");
+		dupOption("aA", "aa");
+		dupOption("Aa--__-_", "aa");
+		dupOption("a_a", "aa");
+		dupOption("a__a", "aa");
+		dupOption("a___a", "aa");
+		dupOption("a_a_", "aa");
+		dupOption("-a_a", "-aa");
+		dupOption("-a_a_", "-aa");
+		dupOption("--a__a__", "--aa");
+		dupOption("---a___a___", "---aa");
+
+		dupOption("a_A", "aa");
+		dupOption("A_-a", "aa");
+		dupOption("A--_A", "aa");
+		dupOption("a_A-", "aa");
+		dupOption("-A---__---__-_A", "-aa");
+		dupOption("---A---__---__-_A", "---aa");
+	}
+
+
+	static void TestVectors1 ()
+	{
+		std::wstringstream ss;
+
+		Opts opts(testConfig);
+
+		opts.AddOption(empty, [&] (String str) {
+			Dump(ss, str);
+		});
+		opts.AddOption(Q("x"), [&] (std::vector<String> && strs) {
+			DumpMemo(ss, L"<vector>");
+			for (String const & str : strs) {
+				Dump(ss, str);
+			}
+			DumpMemo(ss, L"</vector>");
+		});
+
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		args.push_back(Q("a"));
+		Dump(expected, L"a");
+
+		args.push_back(Q("b"));
+		Dump(expected, L"b");
+
+		args.push_back(Q("x"));
+		DumpMemo(expected, L"<vector>");{
+			args.push_back(Q("x"));
+			Dump(expected, L"x");
+	
+			args.push_back(Q("b"));
+			Dump(expected, L"b");
+
+			args.push_back(Q("c"));
+			Dump(expected, L"c");
+
+			args.push_back(Q("x"));
+			Dump(expected, L"x");
+		}DumpMemo(expected, L"</vector>");
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+
+
+	static void TestVectors2 ()
+	{
+		std::wstringstream ss;
+
+		Opts opts(testConfig);
+
+		opts.AddOption(empty, [&] (String str) {
+			Dump(ss, str);
+		});
+		opts.AddOption(Q("x"), [&] (std::vector<String> && strs) {
+			DumpMemo(ss, L"<vector>");
+			for (String const & str : strs) {
+				Dump(ss, str);
+			}
+			DumpMemo(ss, L"</vector>");
+		});
+
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		args.push_back(Q("a"));
+		Dump(expected, L"a");
+
+		args.push_back(Q("b"));
+		Dump(expected, L"b");
+
+		args.push_back(Q("x"));
+		DumpMemo(expected, L"<vector>");
+		DumpMemo(expected, L"</vector>");
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+
+	
+	static void TestOutputSpan ()
+	{
+		std::wstringstream ss;
+
+		float weights[3] = { 0, 0, 0 };
+		String names[2];
+
+		Opts opts(testConfig);
+		opts.AddOption(Q("w"), lambda_options::Span<float>(weights), [&] (lambda_options::Span<float> written) {
+			DumpMemo(ss, L"<weights>");
+			if (written.Data() != weights) {
+				FAIL;
+			}
+			for (float w : written) {
+				Dump(ss, w);
+			}
+			DumpMemo(ss, L"</weights>");
+		});
+		opts.AddOption(Q("n"), lambda_options::Span<String>(names), [&] (lambda_options::Span<String> written) {
+			Dump(ss, static_cast<unsigned int>(written.Size()));
+		});
+
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		args.push_back(Q("w"));
+		args.push_back(Q("1"));
+		args.push_back(Q("2"));
+		DumpMemo(expected, L"<weights>");
+		Dump(expected, 1.0f);
+		Dump(expected, 2.0f);
+		DumpMemo(expected, L"</weights>");
+
+		args.push_back(Q("w"));
+		DumpMemo(expected, L"<weights>");
+		DumpMemo(expected, L"</weights>");
+
+		args.push_back(Q("w"));
+		args.push_back(Q("3"));
+		args.push_back(Q("4"));
+		args.push_back(Q("5"));
+		args.push_back(Q("6"));
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		try {
+			parseContext.Run();
+			FAIL;
+		}
+		catch (lambda_options::ParseFailedException<Char> const & e) {
+			if (e.beginIndex != 4) {
+				FAIL;
+			}
+			if (e.endIndex != 9) {
+				FAIL;
+			}
+		}
+		// "w" has no other overload, so its values were written as they were parsed, before the overflow.
+		if (weights[0] != 3.0f || weights[1] != 4.0f || weights[2] != 5.0f) {
+			FAIL;
+		}
+
+		args.clear();
+		args.push_back(Q("n"));
+		args.push_back(Q("a"));
+		args.push_back(Q("b"));
+		Dump(expected, 2u);
+
+		auto parseContext2 = opts.CreateParseContext(args.begin(), args.end());
+		parseContext2.Run();
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+		if (names[0] != Q("a") || names[1] != Q("b")) {
+			FAIL;
+		}
+
+		// With another overload on the keyword, values are only written once the span overload is chosen.
+		float staged[2] = { 0, 0 };
+		opts.AddOption(Q("s"), lambda_options::Span<float>(staged), [&] (lambda_options::Span<float> written) {
+			Dump(ss, static_cast<unsigned int>(written.Size()));
+		});
+		opts.AddOption(Q("s"), [&] (int, int, int) {
+			DumpMemo(ss, L"ints");
+		});
+
+		args.clear();
+		args.push_back(Q("s"));
+		args.push_back(Q("1"));
+		args.push_back(Q("2"));
+		args.push_back(Q("3"));
+		DumpMemo(expected, L"ints");
+
+		opts.CreateParseContext(args.begin(), args.end()).Run();
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+		if (staged[0] != 0.0f || staged[1] != 0.0f) {
+			FAIL;
+		}
+
+		args.resize(3);
+		Dump(expected, 2u);
+
+		opts.CreateParseContext(args.begin(), args.end()).Run();
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+		if (staged[0] != 1.0f || staged[1] != 2.0f) {
+			FAIL;
+		}
+	}
+
+
+	static void TestConsumeRest ()
+	{
+		std::wstringstream ss;
+
+		Opts opts(testConfig);
+
+		opts.AddOption(empty, [&] (String str) {
+			Dump(ss, str);
+		});
+		opts.AddOption(Q(";"), lambda_options::ConsumeRest<Char>);
+
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		args.push_back(Q("a"));
+		Dump(expected, L"a");
+
+		args.push_back(Q(";"));
+		args.push_back(Q("b"));
+		args.push_back(Q("c"));
+
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+
+
+	static void TestAny ()
+	{
+		std::wstringstream ss;
+
+		Opts opts(testConfig);
+
+		opts.AddOption(empty, [&] (unsigned int x) {
+			Dump(ss, x);
+		});
+		opts.AddOption(empty, [&] (Any x) {
+			Dump(ss, x);
+		});
+		opts.AddOption(empty, [&] (String x) {
+			Dump(ss, x);
+		});
+
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		args.push_back(Q("a"));
+		Dump(expected, Any());
+
+		args.push_back(Q("1"));
+		Dump(expected, 1u);
+
+		args.push_back(Q("-1"));
+		Dump(expected, Any());
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+
+
+	static void TestGnuShortGrouping1 ()
+	{
+		std::wstringstream ss;
+
+		OptionsConfig config;
+		Opts opts(config);
+
+		Keyword kwFoo(Q("f"), Q("foo"));
+		opts.AddOption(kwFoo, [&] {
+			DumpMemo(ss, L"<foo/>");
+		});
+
+		Keyword kwBar(Q("b"), Q("bar"));
+		opts.AddOption(kwBar, [&] (std::vector<int> xs) {
+			DumpMemo(ss, L"<bar>");
+			Dump(ss, static_cast<unsigned int>(xs.size()));
+			DumpMemo(ss, L"</bar>");
+		});
+
+		Keyword kwWuz(Q("w"), Q("wuz"));
+		opts.AddOption(kwWuz, [&] {
+			DumpMemo(ss, L"<wuz/>");
+		});
+
+		Keyword kwTar(Q("x"), Q("fbx"));
+		opts.AddOption(kwTar, [&] (Any) {
+			DumpMemo(ss, L"<fbx/>");
+		});
+
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		args.push_back(Q("-f"));
+		DumpMemo(expected, L"<foo/>");
+
+		args.push_back(Q("-b"));
+		DumpMemo(expected, L"<bar>");
+		Dump(expected, 0u);
+		DumpMemo(expected, L"</bar>");
+
+		args.push_back(Q("-x"));
+		args.push_back(Q("-1"));
+		DumpMemo(expected, L"<fbx/>");
+
+		args.push_back(Q("--fbx"));
+		args.push_back(Q("-1"));
+		DumpMemo(expected, L"<fbx/>");
+
+		args.push_back(Q("-fb"));
+		DumpMemo(expected, L"<foo/>");
+		DumpMemo(expected, L"<bar>");
+		Dump(expected, 0u);
+		DumpMemo(expected, L"</bar>");
+
+		args.push_back(Q("-bf"));
+		DumpMemo(expected, L"<bar>");
+		Dump(expected, 0u);
+		DumpMemo(expected, L"</bar>");
+		DumpMemo(expected, L"<foo/>");
+
+		args.push_back(Q("-wbf"));
+		DumpMemo(expected, L"<wuz/>");
+		DumpMemo(expected, L"<bar>");
+		Dump(expected, 0u);
+		DumpMemo(expected, L"</bar>");
+		DumpMemo(expected, L"<foo/>");
+
+		args.push_back(Q("-ff"));
+		DumpMemo(expected, L"<foo/>");
+		DumpMemo(expected, L"<foo/>");
+
+		args.push_back(Q("-fxb"));
+		DumpMemo(expected, L"<foo/>");
+		DumpMemo(expected, L"<fbx/>");
+
+		args.push_back(Q("-fq"));
+		args.push_back(Q("-f"));
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		try {
+			parseContext.Run();
+			FAIL;
+		}
+		catch (lambda_options::ParseFailedException<Char> const & e) {
+			if (e.beginIndex != 11) {
+				FAIL;
+			}
+			if (e.endIndex != 12) {
+				FAIL;
+			}
+		}
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+
+
+	static void TestGnuShortGrouping2 ()
+	{
+		std::wstringstream ss;
+
+		OptionsConfig config;
+		Opts opts(config);
+
+		Keyword kwFoo(Q("f"));
+		opts.AddOption(kwFoo, [&] {
+			DumpMemo(ss, L"<f/>");
+		});
+
+		Keyword kwZzy(Q("z"));
+		opts.AddOption(kwZzy, lambda_options::ConsumeRest<Char>);
+
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		args.push_back(Q("-fz"));
+		DumpMemo(expected, L"<f/>");
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+
+
+	static void TestGnuShortGrouping3 ()
+	{
+		std::wstringstream ss;
+
+		OptionsConfig config;
+		Opts opts(config);
+
+		Keyword kwFoo(Q("f"));
+		opts.AddOption(kwFoo, [&] {
+			DumpMemo(ss, L"<f/>");
+		});
+
+		Keyword kwZzy(Q("z"));
+		opts.AddOption(kwZzy, lambda_options::ConsumeRest<Char>);
+
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		args.push_back(Q("-zf"));
+		DumpMemo(expected, L"<f/>");
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+
+
+	static void TestGnuShortGrouping4 ()
+	{
+		std::wstringstream ss;
+
+		OptionsConfig config;
+		Opts opts(config);
+
+		Keyword kwFoo(Q("f"));
+		opts.AddOption(kwFoo, [&] {
+			DumpMemo(ss, L"<f/>");
+		});
+
+		Keyword kwZzy(Q("z"));
+		opts.AddOption(kwZzy, lambda_options::ConsumeRest<Char>);
+
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		args.push_back(Q("-f"));
+		DumpMemo(expected, L"<f/>");
+
+		args.push_back(Q("-zf"));
+		args.push_back(Q("-f"));
+		DumpMemo(expected, L"<f/>");
+		DumpMemo(expected, L"<f/>");
+
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		parseContext.Run();
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+
+
+	static void TestGnuShortGrouping5 ()
+	{
+		std::wstringstream ss;
+
+		OptionsConfig config;
+		Opts opts(config);
+
+		Keyword kwFoo(Q("f"));
+		opts.AddOption(kwFoo, [&] {
+			DumpMemo(ss, L"<f/>");
+		});
+
+		Keyword kwZzy(Q("z"));
+		opts.AddOption(kwZzy, lambda_options::ConsumeRest<Char>);
 
-		badArg("");
-		badArg("A");
-		badArg("-a-");
-		badArg("_-a");
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		args.push_back(Q("-f"));
+		DumpMemo(expected, L"<f/>");
+
+		args.push_back(Q("-fz"));
+		args.push_back(Q("-f"));
+		DumpMemo(expected, L"<f/>");
+		DumpMemo(expected, L"<f/>");
 
 		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
 		parseContext.Run();
-		
-		auto const ssStr = ss.str();
-		auto const expectedStr = expected.str();
-		if (ssStr != expectedStr) {
+
+		if (ss.str() != expected.str()) {
 			FAIL;
 		}
 	}
 
 
-	static void TestMatchFlags4 ()
+	static void TestGnuShortGrouping6 ()
 	{
+		std::wstringstream ss;
+
 		OptionsConfig config;
-		config.keywordStyle = KeywordStyle::Exact;
-		config.matchFlags = MatchFlags::IgnoreAsciiCase | MatchFlags::RelaxedDashes | MatchFlags::RelaxedUnderscores;
+		config.matchFlags = MatchFlags::GnuShortGrouping | MatchFlags::IgnoreAsciiCase;
 		Opts opts(config);
 
-		auto addOption = [&] (char const * name) {
-			opts.AddOption(Q(name), nop);
-		};
+		opts.AddOption(Q("x"), [&] {
+			DumpMemo(ss, L"x");
+		});
+		opts.AddOption(Q("v"), [&] {
+			DumpMemo(ss, L"v");
+		});
+		opts.AddOption(Keyword(Q("z"), Q("zip")), [&] {
+			DumpMemo(ss, L"z");
+		});
+		opts.AddOption(Q("f"), [&] (String) {
+			DumpMemo(ss, L"f");
+		});
 
-		auto dupOption = [&] (char const * name, char const * existingName) {
-			try {
-				addOption(name);
-			}
-			catch (lambda_options::OptionConflictException<Char> const & e) {
-				if (e.conflictingNames.first != Q(name)) {
-					FAIL;
-				}
-				if (e.conflictingNames.second != Q(existingName)) {
-					FAIL;
-				}
-				return;
-			}
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		args.push_back(Q("-xvz"));
+		DumpMemo(expected, L"x");
+		DumpMemo(expected, L"v");
+		DumpMemo(expected, L"z");
+
+		args.push_back(Q("-ZX"));
+		DumpMemo(expected, L"z");
+		DumpMemo(expected, L"x");
+
+		args.push_back(Q("-f"));
+		args.push_back(Q("-xv"));
+		DumpMemo(expected, L"f");
+
+		args.push_back(Q("-xq"));
+
+		lambda_options::ParseFailedException<Char> e;
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (parseContext.Run(e)) {
 			FAIL;
-		};
+		}
+		if (e.beginIndex != 4) {
+			FAIL;
+		}
 
-		addOption("");
-		dupOption("_", "");
-		dupOption("_", "");
-		dupOption("_-", "");
-		dupOption("_-_", "");
-		dupOption("__", "");
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
 
-		addOption("-");
-		dupOption("-_", "-");
-		dupOption("-__--__--", "-");
 
-		addOption("a");
-		addOption("-a");
-		addOption("--A");
-		addOption("---a");
+	static void TestGnuShortGrouping7 ()
+	{
+		std::wstringstream ss;
 
-		dupOption("a", "a");
-		dupOption("a_", "a");
-		dupOption("a__", "a");
-		dupOption("a___", "a");
-		dupOption("-a", "-a");
-		dupOption("--a", "--A");
-		dupOption("---a", "---a");
-		dupOption("-_A", "-a");
-		dupOption("--_A_", "--A");
-		dupOption("---A_", "---a");
+		OptionsConfig config;
+		Opts opts(config);
 
-		addOption("aa");
-		addOption("-aa");
-		addOption("--aa");
-		addOption("---aa");
+		opts.AddOption(Q("x"), [&] {
+			DumpMemo(ss, L"x");
+		});
+		opts.AddOption(Q("v"), [&] {
+			DumpMemo(ss, L"v");
+		});
+		opts.AddOption(Q("f"), [&] (String file) {
+			Dump(ss, file);
+		});
+		opts.AddOption(Q("j"), [&] (int jobs) {
+			Dump(ss, jobs);
+		});
+		opts.AddOption(Q("p"), [&] (int x, int y) {
+			Dump(ss, x);
+			Dump(ss, y);
+		});
+		opts.AddOption(Q("k"), [&] (TestPeekHelper) {
+			DumpMemo(ss, L"k");
+		});
 
-		dupOption("AA", "aa");
-		dupOption("Aa", "aa");
-		dupOption("aA", "aa");
-		dupOption("Aa--__-_", "aa");
-		dupOption("a_a", "aa");
-		dupOption("a__a", "aa");
-		dupOption("a___a", "aa");
-		dupOption("a_a_", "aa");
-		dupOption("-a_a", "-aa");
-		dupOption("-a_a_", "-aa");
-		dupOption("--a__a__", "--aa");
-		dupOption("---a___a___", "---aa");
+		std::wstringstream expected;
+		std::vector<String> args;
 
-		dupOption("a_A", "aa");
-		dupOption("A_-a", "aa");
-		dupOption("A--_A", "aa");
-		dupOption("a_A-", "aa");
-		dupOption("-A---__---__-_A", "-aa");
-		dupOption("---A---__---__-_A", "---aa");
+		args.push_back(Q("-xvf"));
+		args.push_back(Q("archive.tar"));
+		DumpMemo(expected, L"x");
+		DumpMemo(expected, L"v");
+		Dump(expected, L"archive.tar");
+
+		args.push_back(Q("-j8"));
+		Dump(expected, 8);
+
+		args.push_back(Q("-vj12"));
+		DumpMemo(expected, L"v");
+		Dump(expected, 12);
+
+		args.push_back(Q("-xj"));
+		args.push_back(Q("3"));
+		DumpMemo(expected, L"x");
+		Dump(expected, 3);
+
+		args.push_back(Q("-p1"));
+		args.push_back(Q("2"));
+		Dump(expected, 1);
+		Dump(expected, 2);
+
+		args.push_back(Q("-fx"));
+		Dump(expected, L"x");
+
+		args.push_back(Q("-jz"));
+
+		lambda_options::ParseFailedException<Char> e;
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (parseContext.Run(e)) {
+			FAIL;
+		}
+		if (e.beginIndex != 9) {
+			FAIL;
+		}
+		if (parseContext.Args()[9] != Q("-jz")) {
+			FAIL;
+		}
+
+		// An overload that would leave the glued value unused does not run.
+		args.clear();
+		args.push_back(Q("-kz"));
+		parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (parseContext.Run(e)) {
+			FAIL;
+		}
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+
+		// With a keyword-less option, flags still run in place. One whose function rejects is passed on as "-c",
+		// without running its function again.
+		Opts withKeywordless(config);
+		size_t quietCalls = 0;
+		withKeywordless.AddOption(Q("x"), [&] {
+			DumpMemo(ss, L"x");
+		});
+		withKeywordless.AddOption(Q("q"), [&] {
+			++quietCalls;
+			return lambda_options::Verdict<Char>::Reject(0, Q("no"));
+		});
+		withKeywordless.AddOption(Keyword(), [&] (String arg) {
+			Dump(ss, arg);
+		});
+
+		ss.str(L"");
+		expected.str(L"");
+		args.clear();
+		args.push_back(Q("-xqx"));
+		DumpMemo(expected, L"x");
+		Dump(expected, L"-q");
+		DumpMemo(expected, L"x");
+
+		withKeywordless.CreateParseContext(args.begin(), args.end()).Run();
+		if (ss.str() != expected.str() || quietCalls != 1) {
+			FAIL;
+		}
 	}
 
 
-	static void TestVectors1 ()
+	static void TestAttachedValue ()
 	{
 		std::wstringstream ss;
 
-		Opts opts(testConfig);
+		OptionsConfig config;
+		Opts opts(config);
 
-		opts.AddOption(empty, [&] (String str) {
-			Dump(ss, str);
+		opts.AddOption(Q("threads"), [&] (int threads) {
+			Dump(ss, threads);
 		});
-		opts.AddOption(Q("x"), [&] (std::vector<String> && strs) {
-			DumpMemo(ss, L"<vector>");
-			for (String const & str : strs) {
-				Dump(ss, str);
-			}
-			DumpMemo(ss, L"</vector>");
+		opts.AddOption(Q("name"), [&] (String name) {
+			Dump(ss, name);
+		});
+		opts.AddOption(Q("point"), [&] (int x, int y) {
+			Dump(ss, x);
+			Dump(ss, y);
+		});
+		opts.AddOption(Q("verbose"), [&] {
+			DumpMemo(ss, L"verbose");
+		});
+		opts.AddOption(Q("nums"), [&] (std::vector<int> nums) {
+			DumpMemo(ss, L"nums");
+			Dump(ss, static_cast<unsigned int>(nums.size()));
+		});
+		std::vector<lambda_options::Lazy<int>> lazies;
+		opts.AddOption(Q("lazy"), [&] (lambda_options::Lazy<int> x) {
+			lazies.push_back(std::move(x));
+		});
+		opts.AddOption(Keyword(), [&] (String arg) {
+			DumpMemo(ss, L"other");
+			Dump(ss, arg);
 		});
 
 		std::wstringstream expected;
 		std::vector<String> args;
 
-		args.push_back(Q("a"));
-		Dump(expected, L"a");
+		args.push_back(Q("--threads=8"));
+		Dump(expected, 8);
 
-		args.push_back(Q("b"));
-		Dump(expected, L"b");
+		args.push_back(Q("--name=a=b"));
+		Dump(expected, L"a=b");
 
-		args.push_back(Q("x"));
-		DumpMemo(expected, L"<vector>");{
-			args.push_back(Q("x"));
-			Dump(expected, L"x");
-	
-			args.push_back(Q("b"));
-			Dump(expected, L"b");
+		args.push_back(Q("--name="));
+		Dump(expected, L"");
 
-			args.push_back(Q("c"));
-			Dump(expected, L"c");
+		args.push_back(Q("--point=1"));
+		args.push_back(Q("2"));
+		Dump(expected, 1);
+		Dump(expected, 2);
 
-			args.push_back(Q("x"));
-			Dump(expected, L"x");
-		}DumpMemo(expected, L"</vector>");
+		args.push_back(Q("--verbose=yes"));
+		DumpMemo(expected, L"other");
+		Dump(expected, L"--verbose=yes");
 
-		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
-		parseContext.Run();
+		args.push_back(Q("--nums=3"));
+		DumpMemo(expected, L"nums");
+		Dump(expected, 1u);
+
+		// The vector could parse without the value, but that overload is rejected before its callback runs.
+		args.push_back(Q("--nums=x"));
+		DumpMemo(expected, L"other");
+		Dump(expected, L"--nums=x");
+
+		args.push_back(Q("--lazy=5"));
+		args.push_back(Q("--threads=9"));
+		Dump(expected, 9);
+
+		{
+			auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+			parseContext.Run();
+			if (lazies.size() != 1 || lazies[0].TryGet() == nullptr || *lazies[0].TryGet() != 5) {
+				FAIL;
+			}
+			if (parseContext.Args()[0] != Q("--threads=8")) {
+				FAIL;
+			}
+		}
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+
+		// When several keywords share the name, the choice does not depend on the keyword order.
+		ss.str(L"");
+		expected.str(L"");
+		auto addSized = [&] (Opts & sizedOpts) {
+			sizedOpts.AddOption(Keyword(Q("size"), Q("s")), [&] (int size) {
+				Dump(ss, size);
+			});
+			sizedOpts.AddOption(Keyword(Q("size"), Q("z")), [&] (String size) {
+				DumpMemo(ss, L"string");
+				Dump(ss, size);
+			});
+		};
+		Opts sized(config);
+		addSized(sized);
+		Opts profiled(config);
+		addSized(profiled);
+		std::vector<size_t> hits;
+		hits.push_back(0);
+		hits.push_back(10);
+		profiled.LoadOverloadProfile(hits);
+
+		args.clear();
+		args.push_back(Q("--size=7"));
+		args.push_back(Q("--size"));
+		args.push_back(Q("7"));
+		Dump(expected, 7);
+		Dump(expected, 7);
+		Dump(expected, 7);
+		Dump(expected, 7);
+		sized.CreateParseContext(args.begin(), args.end()).Run();
+		profiled.CreateParseContext(args.begin(), args.end()).Run();
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+
+		ss.str(L"");
+		config.keywordStyle = KeywordStyle::Windows;
+		Opts windowsOpts(config);
+		windowsOpts.AddOption(Q("threads"), [&] (int threads) {
+			Dump(ss, threads);
+		});
+
+		args.clear();
+		args.push_back(Q("/threads:4"));
+		args.push_back(Q("/threads"));
+		args.push_back(Q("5"));
+		expected.str(L"");
+		Dump(expected, 4);
+		Dump(expected, 5);
+
+		args.push_back(Q("/threads:z"));
 
+		lambda_options::ParseFailedException<Char> e;
+		auto parseContext = windowsOpts.CreateParseContext(args.begin(), args.end());
+		if (parseContext.Run(e)) {
+			FAIL;
+		}
+		if (e.beginIndex != 3) {
+			FAIL;
+		}
+		if (parseContext.Args()[3] != Q("/threads:z")) {
+			FAIL;
+		}
 		if (ss.str() != expected.str()) {
 			FAIL;
 		}
 	}
 
 
-	static void TestVectors2 ()
+	static void TestJoinedPrefix ()
 	{
 		std::wstringstream ss;
 
-		Opts opts(testConfig);
+		OptionsConfig config;
+		Opts opts(config);
 
-		opts.AddOption(empty, [&] (String str) {
-			Dump(ss, str);
+		opts.AddOption(Keyword(Q("include")).Prefix(Q("-I")), [&] (String dir) {
+			DumpMemo(ss, L"I");
+			Dump(ss, dir);
 		});
-		opts.AddOption(Q("x"), [&] (std::vector<String> && strs) {
-			DumpMemo(ss, L"<vector>");
-			for (String const & str : strs) {
-				Dump(ss, str);
-			}
-			DumpMemo(ss, L"</vector>");
+		opts.AddOption(Keyword().Prefix(Q("-W")), [&] (String warning) {
+			DumpMemo(ss, L"W");
+			Dump(ss, warning);
+		});
+		opts.AddOption(Keyword().Prefix(Q("-Wno-")), [&] (int warning) {
+			DumpMemo(ss, L"Wno");
+			Dump(ss, warning);
+		});
+		opts.AddOption(Keyword().Prefix(Q("-O")), [&] (int level) {
+			DumpMemo(ss, L"O");
+			Dump(ss, level);
 		});
 
 		std::wstringstream expected;
 		std::vector<String> args;
 
-		args.push_back(Q("a"));
-		Dump(expected, L"a");
+		args.push_back(Q("-I/usr/include"));
+		DumpMemo(expected, L"I");
+		Dump(expected, L"/usr/include");
 
-		args.push_back(Q("b"));
-		Dump(expected, L"b");
+		args.push_back(Q("-I"));
+		args.push_back(Q("lib"));
+		DumpMemo(expected, L"I");
+		Dump(expected, L"lib");
 
-		args.push_back(Q("x"));
-		DumpMemo(expected, L"<vector>");
-		DumpMemo(expected, L"</vector>");
+		args.push_back(Q("--include"));
+		args.push_back(Q("src"));
+		DumpMemo(expected, L"I");
+		Dump(expected, L"src");
 
-		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
-		parseContext.Run();
+		args.push_back(Q("-Wall"));
+		DumpMemo(expected, L"W");
+		Dump(expected, L"all");
+
+		args.push_back(Q("-Wno-42"));
+		DumpMemo(expected, L"Wno");
+		Dump(expected, 42);
+
+		args.push_back(Q("-Wno-unused"));
+		DumpMemo(expected, L"W");
+		Dump(expected, L"no-unused");
+
+		args.push_back(Q("-O2"));
+		DumpMemo(expected, L"O");
+		Dump(expected, 2);
+
+		args.push_back(Q("-Ofast"));
 
+		lambda_options::ParseFailedException<Char> e;
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (parseContext.Run(e)) {
+			FAIL;
+		}
+		if (e.beginIndex != 9) {
+			FAIL;
+		}
+		if (parseContext.Args()[9] != Q("-Ofast")) {
+			FAIL;
+		}
 		if (ss.str() != expected.str()) {
 			FAIL;
 		}
+
+		bool threw = false;
+		try {
+			opts.AddOption(Keyword().Prefix(Q("-O")), [] (int) {});
+		}
+		catch (lambda_options::OptionConflictException<Char> const &) {
+			threw = true;
+		}
+		if (!threw) {
+			FAIL;
+		}
 	}
 
-	
-	static void TestConsumeRest ()
+
+	static void TestNegatable ()
 	{
 		std::wstringstream ss;
 
-		Opts opts(testConfig);
+		OptionsConfig config;
+		Opts opts(config);
 
-		opts.AddOption(empty, [&] (String str) {
-			Dump(ss, str);
+		opts.AddOption(Keyword(Q("color"), Q("c")).Negatable(), [&] (bool color) {
+			Dump(ss, color);
+		});
+		opts.AddOption(Q("width"), [&] (int width) {
+			Dump(ss, width);
 		});
-		opts.AddOption(Q(";"), lambda_options::ConsumeRest<Char>);
 
 		std::wstringstream expected;
 		std::vector<String> args;
 
-		args.push_back(Q("a"));
-		Dump(expected, L"a");
+		args.push_back(Q("--color"));
+		Dump(expected, true);
 
-		args.push_back(Q(";"));
-		args.push_back(Q("b"));
-		args.push_back(Q("c"));
+		args.push_back(Q("--no-color"));
+		Dump(expected, false);
 
+		args.push_back(Q("-c"));
+		Dump(expected, true);
 
-		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
-		parseContext.Run();
+		args.push_back(Q("--width"));
+		args.push_back(Q("80"));
+		Dump(expected, 80);
+
+		args.push_back(Q("--no-c"));
 
+		lambda_options::ParseFailedException<Char> e;
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (parseContext.Run(e)) {
+			FAIL;
+		}
+		if (e.beginIndex != 5) {
+			FAIL;
+		}
 		if (ss.str() != expected.str()) {
 			FAIL;
 		}
-	}
 
+		bool threw = false;
+		try {
+			opts.AddOption(Keyword(Q("no-color")), [] () {});
+		}
+		catch (lambda_options::OptionConflictException<Char> const &) {
+			threw = true;
+		}
+		if (!threw) {
+			FAIL;
+		}
 
-	static void TestAny ()
-	{
-		std::wstringstream ss;
-
-		Opts opts(testConfig);
+		threw = false;
+		try {
+			opts.AddOption(Keyword(Q("size")).Negatable(), [] (int) {});
+		}
+		catch (lambda_options::NegatableSignatureException const &) {
+			threw = true;
+		}
+		if (!threw) {
+			FAIL;
+		}
 
-		opts.AddOption(empty, [&] (unsigned int x) {
-			Dump(ss, x);
-		});
-		opts.AddOption(empty, [&] (Any x) {
-			Dump(ss, x);
+		// The short form in a group is not negated by a "no-" long form just before it.
+		Opts groupOpts(config);
+		groupOpts.AddOption(Keyword(Q("foo"), Q("f")).Negatable(), [&] (bool foo) {
+			Dump(ss, foo);
 		});
-		opts.AddOption(empty, [&] (String x) {
-			Dump(ss, x);
+		groupOpts.AddOption(Keyword(Q("x")), [&] () {
+			Dump(ss, Q("x"));
 		});
 
-		std::wstringstream expected;
-		std::vector<String> args;
-
-		args.push_back(Q("a"));
-		Dump(expected, Any());
+		ss.str(L"");
+		expected.str(L"");
+		args.clear();
 
-		args.push_back(Q("1"));
-		Dump(expected, 1u);
+		args.push_back(Q("--no-foo"));
+		Dump(expected, false);
 
-		args.push_back(Q("-1"));
-		Dump(expected, Any());
+		args.push_back(Q("-fx"));
+		Dump(expected, true);
+		Dump(expected, Q("x"));
 
-		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
-		parseContext.Run();
+		args.push_back(Q("--no-foo"));
+		Dump(expected, false);
 
+		groupOpts.CreateParseContext(args.begin(), args.end()).Run();
 		if (ss.str() != expected.str()) {
 			FAIL;
 		}
 	}
 
 
-	static void TestGnuShortGrouping1 ()
+	static void TestCountedFlag ()
 	{
 		std::wstringstream ss;
 
 		OptionsConfig config;
 		Opts opts(config);
 
-		Keyword kwFoo(Q("f"), Q("foo"));
-		opts.AddOption(kwFoo, [&] {
-			DumpMemo(ss, L"<foo/>");
-		});
-
-		Keyword kwBar(Q("b"), Q("bar"));
-		opts.AddOption(kwBar, [&] (std::vector<int> xs) {
-			DumpMemo(ss, L"<bar>");
-			Dump(ss, static_cast<unsigned int>(xs.size()));
-			DumpMemo(ss, L"</bar>");
+		size_t calls = 0;
+		opts.AddOption(Keyword(Q("verbose"), Q("v")).Counted(), [&] (unsigned int verbosity) {
+			Dump(ss, verbosity);
+			++calls;
 		});
-
-		Keyword kwWuz(Q("w"), Q("wuz"));
-		opts.AddOption(kwWuz, [&] {
-			DumpMemo(ss, L"<wuz/>");
+		opts.AddOption(Q("x"), [&] {
+			DumpMemo(ss, L"x");
 		});
-
-		Keyword kwTar(Q("x"), Q("fbx"));
-		opts.AddOption(kwTar, [&] (Any) {
-			DumpMemo(ss, L"<fbx/>");
+		opts.AddOption(Keyword(), [&] (String arg) {
+			Dump(ss, arg);
 		});
 
 		std::wstringstream expected;
 		std::vector<String> args;
 
-		args.push_back(Q("-f"));
-		DumpMemo(expected, L"<foo/>");
+		args.push_back(Q("-v"));
+		args.push_back(Q("--verbose"));
+		args.push_back(Q("-vxv"));
+		DumpMemo(expected, L"x");
+		args.push_back(Q("file"));
+		Dump(expected, L"file");
+		args.push_back(Q("-vv"));
+		Dump(expected, 6u);
 
-		args.push_back(Q("-b"));
-		DumpMemo(expected, L"<bar>");
-		Dump(expected, 0u);
-		DumpMemo(expected, L"</bar>");
+		opts.CreateParseContext(args.begin(), args.end()).Run();
+		if (ss.str() != expected.str() || calls != 1) {
+			FAIL;
+		}
 
+		args.clear();
 		args.push_back(Q("-x"));
-		args.push_back(Q("-1"));
-		DumpMemo(expected, L"<fbx/>");
-
-		args.push_back(Q("--fbx"));
-		args.push_back(Q("-1"));
-		DumpMemo(expected, L"<fbx/>");
-
-		args.push_back(Q("-fb"));
-		DumpMemo(expected, L"<foo/>");
-		DumpMemo(expected, L"<bar>");
-		Dump(expected, 0u);
-		DumpMemo(expected, L"</bar>");
-
-		args.push_back(Q("-bf"));
-		DumpMemo(expected, L"<bar>");
-		Dump(expected, 0u);
-		DumpMemo(expected, L"</bar>");
-		DumpMemo(expected, L"<foo/>");
-
-		args.push_back(Q("-wbf"));
-		DumpMemo(expected, L"<wuz/>");
-		DumpMemo(expected, L"<bar>");
-		Dump(expected, 0u);
-		DumpMemo(expected, L"</bar>");
-		DumpMemo(expected, L"<foo/>");
-
-		args.push_back(Q("-ff"));
-		DumpMemo(expected, L"<foo/>");
-		DumpMemo(expected, L"<foo/>");
+		opts.CreateParseContext(args.begin(), args.end()).Run();
+		if (calls != 1) {
+			FAIL;
+		}
 
-		args.push_back(Q("-fxb"));
-		args.push_back(Q("-f"));
-		args.push_back(Q("-f"));
-		DumpMemo(expected, L"<foo/>");
+		// A rejected count fails the parse at the first occurrence.
+		Opts limited(config);
+		limited.AddOption(Keyword(Q("v")).Counted(), [&] (int verbosity) {
+			if (verbosity > 2) {
+				return lambda_options::Verdict<Char>::Reject(0, Q("too verbose"));
+			}
+			return lambda_options::Verdict<Char>::Accept();
+		});
+		limited.AddOption(Keyword(), [&] (String) {});
+		args.clear();
+		args.push_back(Q("file"));
+		args.push_back(Q("-v"));
+		args.push_back(Q("-vv"));
+		lambda_options::ParseFailedException<Char> e;
+		if (limited.CreateParseContext(args.begin(), args.end()).Run(e)) {
+			FAIL;
+		}
+		if (e.beginIndex != 1 || e.endIndex != 2) {
+			FAIL;
+		}
+		if (e.Message() != Q("Bad input for `-v' at index 1: `-v' - too verbose")) {
+			FAIL;
+		}
+		args.pop_back();
+		if (!limited.CreateParseContext(args.begin(), args.end()).Run(e)) {
+			FAIL;
+		}
 
-		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
-		try {
-			parseContext.Run();
+		// The rejection is reported at the flag itself, whether or not anything follows it.
+		args.clear();
+		args.push_back(Q("-vvv"));
+		if (limited.CreateParseContext(args.begin(), args.end()).Run(e)) {
 			FAIL;
 		}
-		catch (lambda_options::ParseFailedException<Char> const & e) {
-			if (e.beginIndex != 10) {
-				FAIL;
-			}
-			if (e.endIndex != 11) {
-				FAIL;
-			}
+		if (e.beginIndex != 0 || e.endIndex != 1) {
+			FAIL;
+		}
+		args.push_back(Q("a"));
+		if (limited.CreateParseContext(args.begin(), args.end()).Run(e)) {
+			FAIL;
+		}
+		if (e.Message() != Q("Bad input for `-vvv' at index 0: `-vvv' - too verbose")) {
+			FAIL;
 		}
 
-		if (ss.str() != expected.str()) {
+		bool threw = false;
+		try {
+			opts.AddOption(Keyword(Q("quiet")).Counted(), [] (String) {});
+		}
+		catch (lambda_options::CountedSignatureException const &) {
+			threw = true;
+		}
+		if (!threw) {
 			FAIL;
 		}
 	}
 
 
-	static void TestGnuShortGrouping2 ()
+	static void TestCollectedOption ()
 	{
 		std::wstringstream ss;
 
-		OptionsConfig config;
-		Opts opts(config);
+		Opts opts(testConfig);
 
-		Keyword kwFoo(Q("f"));
-		opts.AddOption(kwFoo, [&] {
-			DumpMemo(ss, L"<f/>");
+		size_t calls = 0;
+		std::vector<std::pair<int, int>> const * pointsSeen = nullptr;
+		std::pair<int, int> const * pointsData = nullptr;
+		opts.AddCollectedOption(Q("point"), [&] (std::vector<std::pair<int, int>> const & points) {
+			for (auto const & point : points) {
+				Dump(ss, point.first);
+				Dump(ss, point.second);
+			}
+			pointsSeen = &points;
+			pointsData = points.data();
+			++calls;
+		});
+		opts.AddOption(Q("name"), [&] (String name) {
+			Dump(ss, name);
+		});
+		opts.AddCollectedOption(Q("tag"), [&] (std::vector<String> tags) {
+			Dump(ss, static_cast<unsigned int>(tags.size()));
 		});
 
-		Keyword kwZzy(Q("z"));
-		opts.AddOption(kwZzy, lambda_options::ConsumeRest<Char>);
+		auto collectedKeyword = [&] (std::function<void()> const & addOption) {
+			try {
+				addOption();
+			}
+			catch (lambda_options::CollectedKeywordException const &) {
+				return;
+			}
+			FAIL;
+		};
+		collectedKeyword([&] () { opts.AddCollectedOption(Keyword(Q("count")).Counted(), [] (std::vector<int> const &) {}); });
+		collectedKeyword([&] () { opts.AddCollectedOption(Keyword(Q("flag")).Negatable(), [] (std::vector<bool>) {}); });
 
 		std::wstringstream expected;
 		std::vector<String> args;
 
-		args.push_back(Q("-fz"));
-		DumpMemo(expected, L"<f/>");
+		args.push_back(Q("point"));
+		args.push_back(Q("1"));
+		args.push_back(Q("2"));
+		args.push_back(Q("name"));
+		args.push_back(Q("a"));
+		Dump(expected, L"a");
+		args.push_back(Q("point"));
+		args.push_back(Q("3"));
+		args.push_back(Q("4"));
+		args.push_back(Q("tag"));
+		args.push_back(Q("x"));
+		Dump(expected, 1);
+		Dump(expected, 2);
+		Dump(expected, 3);
+		Dump(expected, 4);
+		Dump(expected, 1u);
 
 		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
 		parseContext.Run();
-
-		if (ss.str() != expected.str()) {
+		if (ss.str() != expected.str() || calls != 1) {
 			FAIL;
-		}
-	}
-
-
-	static void TestGnuShortGrouping3 ()
-	{
-		std::wstringstream ss;
-
-		OptionsConfig config;
-		Opts opts(config);
-
-		Keyword kwFoo(Q("f"));
-		opts.AddOption(kwFoo, [&] {
-			DumpMemo(ss, L"<f/>");
-		});
-
-		Keyword kwZzy(Q("z"));
-		opts.AddOption(kwZzy, lambda_options::ConsumeRest<Char>);
-
-		std::wstringstream expected;
-		std::vector<String> args;
-
-		args.push_back(Q("-zf"));
-		DumpMemo(expected, L"<f/>");
+		}
 
-		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		// A batch taken by reference keeps its storage from one run to the next.
+		std::vector<std::pair<int, int>> const * const firstPoints = pointsSeen;
+		std::pair<int, int> const * const firstData = pointsData;
+		ss.str(L"");
 		parseContext.Run();
+		if (ss.str() != expected.str() || calls != 2) {
+			FAIL;
+		}
+		if (pointsSeen != firstPoints || pointsData != firstData) {
+			FAIL;
+		}
 
-		if (ss.str() != expected.str()) {
+		args.clear();
+		args.push_back(Q("name"));
+		args.push_back(Q("b"));
+		opts.CreateParseContext(args.begin(), args.end()).Run();
+		if (calls != 2) {
+			FAIL;
+		}
+
+		// A rejected batch is reported at the option's first occurrence.
+		opts.AddCollectedOption(Q("limit"), [&] (std::vector<int> const & limits) {
+			if (limits.size() > 1) {
+				return lambda_options::Verdict<Char>::Reject(0, Q("given twice"));
+			}
+			return lambda_options::Verdict<Char>::Accept();
+		});
+		args.push_back(Q("limit"));
+		args.push_back(Q("1"));
+		args.push_back(Q("limit"));
+		args.push_back(Q("2"));
+		lambda_options::ParseFailedException<Char> e;
+		if (opts.CreateParseContext(args.begin(), args.end()).Run(e)) {
+			FAIL;
+		}
+		if (e.beginIndex != 2 || e.endIndex != 3) {
+			FAIL;
+		}
+		if (e.Message() != Q("Bad input for `limit' at index 2: `limit' - given twice")) {
 			FAIL;
 		}
 	}
 
 
-	static void TestGnuShortGrouping4 ()
+	static void TestPositionalBatch ()
 	{
 		std::wstringstream ss;
 
 		OptionsConfig config;
 		Opts opts(config);
 
-		Keyword kwFoo(Q("f"));
-		opts.AddOption(kwFoo, [&] {
-			DumpMemo(ss, L"<f/>");
+		opts.AddOption(Keyword(Q("verbose"), Q("v")), [&] {
+			DumpMemo(ss, L"verbose");
+		});
+		opts.AddOption(Q("out"), [&] (String out) {
+			DumpMemo(ss, L"out");
+			Dump(ss, out);
+		});
+		opts.AddPositionalBatch([&] (lambda_options::Span<String const> batch) {
+			Dump(ss, static_cast<unsigned int>(batch.Size()));
+			for (String const & arg : batch) {
+				Dump(ss, arg);
+			}
 		});
-
-		Keyword kwZzy(Q("z"));
-		opts.AddOption(kwZzy, lambda_options::ConsumeRest<Char>);
 
 		std::wstringstream expected;
 		std::vector<String> args;
 
-		args.push_back(Q("-f"));
-		DumpMemo(expected, L"<f/>");
+		args.push_back(Q("a"));
+		args.push_back(Q("b"));
+		args.push_back(Q("c"));
+		Dump(expected, 3u);
+		Dump(expected, L"a");
+		Dump(expected, L"b");
+		Dump(expected, L"c");
 
-		args.push_back(Q("-zf"));
-		args.push_back(Q("-f"));
-		DumpMemo(expected, L"<f/>");
-		DumpMemo(expected, L"<f/>");
+		args.push_back(Q("--verbose"));
+		DumpMemo(expected, L"verbose");
 
-		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
-		parseContext.Run();
+		args.push_back(Q("d"));
+		Dump(expected, 1u);
+		Dump(expected, L"d");
+
+		args.push_back(Q("-x"));
+		args.push_back(Q("e"));
+		Dump(expected, 2u);
+		Dump(expected, L"-x");
+		Dump(expected, L"e");
+
+		args.push_back(Q("--out"));
+		args.push_back(Q("f"));
+		DumpMemo(expected, L"out");
+		Dump(expected, L"f");
+
+		args.push_back(Q("g"));
+		Dump(expected, 1u);
+		Dump(expected, L"g");
 
+		opts.CreateParseContext(args.begin(), args.end()).Run();
 		if (ss.str() != expected.str()) {
 			FAIL;
 		}
+
+		bool threw = false;
+		try {
+			opts.AddPositionalBatch([] (lambda_options::Span<String const>) {});
+		}
+		catch (lambda_options::HandlerConflictException const &) {
+			threw = true;
+		}
+		if (!threw) {
+			FAIL;
+		}
 	}
 
 
-	static void TestGnuShortGrouping5 ()
+	static void TestEndOfOptions ()
 	{
 		std::wstringstream ss;
 
 		OptionsConfig config;
+		config.endOfOptions = true;
 		Opts opts(config);
 
-		Keyword kwFoo(Q("f"));
-		opts.AddOption(kwFoo, [&] {
-			DumpMemo(ss, L"<f/>");
+		opts.AddOption(Q("help"), [&] {
+			DumpMemo(ss, L"help");
+		});
+		opts.AddOption(Keyword(), [&] (String arg) {
+			Dump(ss, arg);
 		});
-
-		Keyword kwZzy(Q("z"));
-		opts.AddOption(kwZzy, lambda_options::ConsumeRest<Char>);
 
 		std::wstringstream expected;
 		std::vector<String> args;
 
-		args.push_back(Q("-f"));
-		DumpMemo(expected, L"<f/>");
+		args.push_back(Q("--help"));
+		DumpMemo(expected, L"help");
+		args.push_back(Q("a"));
+		Dump(expected, L"a");
+		args.push_back(Q("--"));
+		args.push_back(Q("--help"));
+		Dump(expected, L"--help");
+		args.push_back(Q("--"));
+		Dump(expected, L"--");
 
-		args.push_back(Q("-fz"));
-		args.push_back(Q("-f"));
-		DumpMemo(expected, L"<f/>");
-		DumpMemo(expected, L"<f/>");
+		opts.CreateParseContext(args.begin(), args.end()).Run();
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
 
-		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
-		parseContext.Run();
+		ss.str(L"");
+		expected.str(L"");
+		Opts restOpts(config);
+		restOpts.AddOption(Q("help"), [&] {
+			DumpMemo(ss, L"help");
+		});
+		restOpts.AddRestHandler([&] (lambda_options::Span<String const> rest) {
+			Dump(ss, static_cast<unsigned int>(rest.Size()));
+			for (String const & arg : rest) {
+				Dump(ss, arg);
+			}
+		});
+
+		args.clear();
+		args.push_back(Q("--help"));
+		DumpMemo(expected, L"help");
+		args.push_back(Q("--"));
+		args.push_back(Q("--help"));
+		args.push_back(Q("b"));
+		Dump(expected, 2u);
+		Dump(expected, L"--help");
+		Dump(expected, L"b");
 
+		restOpts.CreateParseContext(args.begin(), args.end()).Run();
 		if (ss.str() != expected.str()) {
 			FAIL;
 		}
+
+		bool threw = false;
+		try {
+			restOpts.AddRestHandler([] (lambda_options::Span<String const>) {});
+		}
+		catch (lambda_options::HandlerConflictException const & e) {
+			threw = std::string(e.what()).find("rest handler") != std::string::npos;
+		}
+		if (!threw) {
+			FAIL;
+		}
 	}
 
 
@@ -2248,6 +4296,267 @@ public:
 	}
 
 
+	static void TestVerdict ()
+	{
+		std::wstringstream ss;
+
+		Opts opts(testConfig);
+
+		opts.AddOption(Q("foo"), [&] (int x, int y) {
+			if (y < 0) {
+				return lambda_options::Verdict<Char>::Reject(1, Q("negative"));
+			}
+			Dump(ss, x);
+			Dump(ss, y);
+			return lambda_options::Verdict<Char>::Accept();
+		});
+		opts.AddOption(Q("bar"), [&] (int x) {
+			Dump(ss, x);
+			return x != 0;
+		});
+
+		std::wstringstream expected;
+		std::vector<String> args;
+
+		args.push_back(Q("foo"));
+		args.push_back(Q("1"));
+		args.push_back(Q("2"));
+		Dump(expected, 1);
+		Dump(expected, 2);
+
+		args.push_back(Q("bar"));
+		args.push_back(Q("3"));
+		Dump(expected, 3);
+
+		args.push_back(Q("foo"));
+		args.push_back(Q("4"));
+		args.push_back(Q("-5"));
+
+		lambda_options::ParseFailedException<Char> e;
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (parseContext.Run(e)) {
+			FAIL;
+		}
+		if (e.beginIndex != 5) {
+			FAIL;
+		}
+		if (e.endIndex != 8) {
+			FAIL;
+		}
+		if (e.Message().find(Q("- negative")) == String::npos) {
+			FAIL;
+		}
+
+		// A bool return value is not a verdict, so false still accepts.
+		args.clear();
+		args.push_back(Q("bar"));
+		args.push_back(Q("0"));
+		Dump(expected, 0);
+
+		parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (!parseContext.Run(e)) {
+			FAIL;
+		}
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+
+
+	static void TestParseFailedMessage ()
+	{
+		Opts opts(testConfig);
+		opts.AddOption(Q("foo"), [] (int) {});
+
+		lambda_options::ParseFailedException<Char> e;
+		{
+			std::vector<String> args;
+			args.push_back(Q("foo"));
+			args.push_back(Q("1"));
+			args.push_back(Q("bar"));
+			auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+			if (parseContext.Run(e)) {
+				FAIL;
+			}
+		}
+		if (e.Message() != Q("Unknown option at index 2: `bar'")) {
+			FAIL;
+		}
+		if (std::string(e.what()) != "Parse failed in argument range [2, 3).") {
+			FAIL;
+		}
+
+		{
+			std::vector<String> args;
+			args.push_back(Q("foo"));
+			auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+			if (parseContext.Run(e)) {
+				FAIL;
+			}
+		}
+		if (e.Message() != Q("Bad input for `foo' at index 1: End of input.")) {
+			FAIL;
+		}
+	}
+
+
+	static void TestSuggestions ()
+	{
+		OptionsConfig config = testConfig;
+		config.suggestionDistance = 2;
+		config.maxSuggestions = 2;
+
+		Opts opts(config);
+		opts.AddOption(Q("--verbose"), nop);
+		opts.AddOption(Q("--version"), nop);
+		opts.AddOption(Keyword(Q("--output"), Q("-o")), [] (String) {});
+		opts.AddOption(Q("--quiet"), nop);
+
+		auto suggest = [&] (char const * arg) {
+			std::vector<String> args;
+			args.push_back(Q(arg));
+			lambda_options::ParseFailedException<Char> e;
+			auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+			if (parseContext.Run(e)) {
+				FAIL;
+			}
+			return e;
+		};
+
+		auto e = suggest("--verbsoe");
+		if (e.suggestions.size() != 1 || e.suggestions[0] != Q("--verbose")) {
+			FAIL;
+		}
+		if (e.Message() != Q("Unknown option at index 0: `--verbsoe' - Did you mean `--verbose'?")) {
+			FAIL;
+		}
+
+		e = suggest("--versoe");
+		if (e.suggestions.size() != 2) {
+			FAIL;
+		}
+		if (e.suggestions[0] != Q("--verbose") || e.suggestions[1] != Q("--version")) {
+			FAIL;
+		}
+
+		e = suggest("--otput");
+		if (e.suggestions.size() != 1 || e.suggestions[0] != Q("--output")) {
+			FAIL;
+		}
+
+		e = suggest("--quit");
+		if (e.suggestions.size() != 1 || e.suggestions[0] != Q("--quiet")) {
+			FAIL;
+		}
+
+		if (!suggest("--nothing-like-it").suggestions.empty()) {
+			FAIL;
+		}
+		if (!suggest("-o").suggestions.empty()) {
+			FAIL;
+		}
+	}
+
+
+	static void TestCollectErrors ()
+	{
+		std::wstringstream ss;
+
+		Opts opts(testConfig);
+		opts.AddOption(Q("--a"), [&] (int x) {
+			Dump(ss, x);
+		});
+		opts.AddOption(Q("--b"), [&] () {
+			Dump(ss, L"b");
+		});
+
+		std::vector<String> args;
+		std::wstringstream expected;
+
+		args.push_back(Q("--a"));
+		args.push_back(Q("1"));
+		Dump(expected, 1);
+
+		args.push_back(Q("--a"));
+		args.push_back(Q("x"));
+		args.push_back(Q("junk"));
+		args.push_back(Q("--b"));
+		args.push_back(Q("--zz"));
+		args.push_back(Q("--a"));
+		args.push_back(Q("2"));
+
+		std::vector<lambda_options::ParseFailedException<Char>> errors;
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (parseContext.Run(errors)) {
+			FAIL;
+		}
+		if (errors.size() != 2) {
+			FAIL;
+		}
+		if (errors[0].beginIndex != 2 || errors[0].endIndex != 4) {
+			FAIL;
+		}
+		if (errors[1].beginIndex != 6 || errors[1].endIndex != 7) {
+			FAIL;
+		}
+
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+
+		size_t const expectedHits[] = { 1, 0 };
+		if (!Equal(opts.OverloadHits(), expectedHits)) {
+			FAIL;
+		}
+
+		errors.clear();
+		args.resize(2);
+		parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (!parseContext.Run(errors) || !errors.empty()) {
+			FAIL;
+		}
+
+		// A failed run does not keep a later run of the same context from running callbacks and delivering totals.
+		OptionsConfig config;
+		Opts rerun(config);
+		bool rejectOnce = true;
+		rerun.AddOption(Keyword(Q("verbose"), Q("v")).Counted(), [&] (unsigned int verbosity) {
+			Dump(ss, verbosity);
+		});
+		rerun.AddOption(Q("apply"), [&] (int x) {
+			if (rejectOnce) {
+				rejectOnce = false;
+				return lambda_options::Verdict<Char>::Reject(0, Q("not yet"));
+			}
+			Dump(ss, x);
+			return lambda_options::Verdict<Char>::Accept();
+		});
+
+		ss.str(L"");
+		expected.str(L"");
+		args.clear();
+		args.push_back(Q("-v"));
+		args.push_back(Q("--apply"));
+		args.push_back(Q("1"));
+		Dump(expected, 1);
+		args.push_back(Q("-v"));
+		Dump(expected, 2u);
+
+		parseContext = rerun.CreateParseContext(args.begin(), args.end());
+		if (parseContext.Run(errors) || errors.size() != 1) {
+			FAIL;
+		}
+		errors.clear();
+		if (!parseContext.Run(errors) || !errors.empty()) {
+			FAIL;
+		}
+		if (ss.str() != expected.str()) {
+			FAIL;
+		}
+	}
+
+
 	static void Test_TEMPLATE ()
 	{
 		std::wstringstream ss;
@@ -2306,9 +4615,27 @@ static bool RunCharTests ()
 		Tests<Char>::TestNoMatch,
 		Tests<Char>::TestKeyword1,
 		Tests<Char>::TestArrays,
+#if LAMBDA_OPTIONS_VARIADIC_TEMPLATES
+		Tests<Char>::TestTuples,
+		Tests<Char>::TestTupleLifetime,
+		Tests<Char>::TestAggregates,
+#endif
+#if LAMBDA_OPTIONS_CPP17
+		Tests<Char>::TestOptionalAndVariant,
+#endif
 		Tests<Char>::TestCustomParser,
 		Tests<Char>::TestParseState,
 		Tests<Char>::TestMaybeLifetime,
+		Tests<Char>::TestLazy,
+		Tests<Char>::TestParseMemo,
+		Tests<Char>::TestOverloadTree,
+		Tests<Char>::TestTokenTraits,
+		Tests<Char>::TestParseLimits,
+		Tests<Char>::TestOverloadProfile,
+		Tests<Char>::TestDeterministic,
+#ifdef LAMBDA_OPTIONS_FILE_MAPPING
+		Tests<Char>::TestFileContents,
+#endif
 		Tests<Char>::TestHelpDescription,
 		Tests<Char>::TestHelpGroups,
 		Tests<Char>::TestKeywordStyle,
@@ -2318,6 +4645,7 @@ static bool RunCharTests ()
 		Tests<Char>::TestMatchFlags4,
 		Tests<Char>::TestVectors1,
 		Tests<Char>::TestVectors2,
+		Tests<Char>::TestOutputSpan,
 		Tests<Char>::TestConsumeRest,
 		Tests<Char>::TestAny,
 		Tests<Char>::TestGnuShortGrouping1,
@@ -2325,8 +4653,21 @@ static bool RunCharTests ()
 		Tests<Char>::TestGnuShortGrouping3,
 		Tests<Char>::TestGnuShortGrouping4,
 		Tests<Char>::TestGnuShortGrouping5,
+		Tests<Char>::TestGnuShortGrouping6,
+		Tests<Char>::TestGnuShortGrouping7,
+		Tests<Char>::TestAttachedValue,
+		Tests<Char>::TestJoinedPrefix,
+		Tests<Char>::TestNegatable,
+		Tests<Char>::TestCountedFlag,
+		Tests<Char>::TestCollectedOption,
+		Tests<Char>::TestPositionalBatch,
+		Tests<Char>::TestEndOfOptions,
 		Tests<Char>::TestRejectArgumentException1,
 		Tests<Char>::TestRejectArgumentException2,
+		Tests<Char>::TestVerdict,
+		Tests<Char>::TestParseFailedMessage,
+		Tests<Char>::TestSuggestions,
+		Tests<Char>::TestCollectErrors,
 	};
 
 	try {
@@ -0,0 +1,215 @@
+// Built with LAMBDA_OPTIONS_NO_THROW and with exceptions disabled (-fno-exceptions, or /EHs-c- with MSVC),
+// so every failure has to come back as a return value.
+#define LAMBDA_OPTIONS_NO_THROW
+#include "../src/LambdaOptions.h"
+
+#include <clocale>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////
+
+
+#define FAIL \
+	do { \
+		std::printf("Failed in '%s' at %d.\n", __FILE__, __LINE__); \
+		return false; \
+	} while (false)
+
+
+//////////////////////////////////////////////////////////////////////////
+
+
+namespace
+{
+	typedef lambda_options::Options<char> Opts;
+	typedef lambda_options::Keyword<char> Keyword;
+	typedef lambda_options::OptionError OptionError;
+	typedef lambda_options::ParseFailedException<char> ParseFailedException;
+	typedef lambda_options::Verdict<char> Verdict;
+
+
+	bool TestOptionErrors ()
+	{
+		Opts opts;
+		if (opts.AddOption("x", [] (int) {}) != OptionError::None) {
+			FAIL;
+		}
+		if (opts.AddOption("x", [] (int) {}) != OptionError::OptionConflict) {
+			FAIL;
+		}
+		if (opts.AddOption(Keyword(), [] () {}) != OptionError::EmptyOption) {
+			FAIL;
+		}
+		if (opts.AddOption(Keyword("size").Negatable(), [] (int) {}) != OptionError::NegatableSignature) {
+			FAIL;
+		}
+		if (opts.AddOption(Keyword("quiet").Counted(), [] (std::string) {}) != OptionError::CountedSignature) {
+			FAIL;
+		}
+		if (opts.AddCollectedOption(Keyword("level").Counted(), [] (std::vector<int> const &) {}) != OptionError::CollectedKeyword) {
+			FAIL;
+		}
+		if (opts.AddPositionalBatch([] (lambda_options::Span<std::string const>) {}) != OptionError::None) {
+			FAIL;
+		}
+		if (opts.AddPositionalBatch([] (lambda_options::Span<std::string const>) {}) != OptionError::HandlerConflict) {
+			FAIL;
+		}
+
+		lambda_options::OptionsConfig config;
+		config.deterministic = true;
+		Opts deterministic(config);
+		if (deterministic.AddOption("a", [] (int) {}) != OptionError::None) {
+			FAIL;
+		}
+		if (deterministic.AddOption("a", [] (std::string) {}) != OptionError::AmbiguousOption) {
+			FAIL;
+		}
+		if (deterministic.AddOption(Keyword().Prefix("-W"), [] (std::string) {}) != OptionError::None) {
+			FAIL;
+		}
+		if (deterministic.AddOption(Keyword().Prefix("-Wl"), [] (int) {}) != OptionError::AmbiguousOption) {
+			FAIL;
+		}
+		return true;
+	}
+
+
+	bool TestRun ()
+	{
+		int sum = 0;
+		Opts opts;
+		opts.AddOption("x", [&] (int value) {
+			if (value < 0) {
+				return Verdict::Reject(0, "negative");
+			}
+			sum += value;
+			return Verdict::Accept();
+		});
+
+		std::vector<std::string> args;
+		args.push_back("-x");
+		args.push_back("1");
+		args.push_back("-x");
+		args.push_back("-2");
+
+		ParseFailedException e;
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (parseContext.Run(e)) {
+			FAIL;
+		}
+		if (sum != 1 || e.beginIndex != 2 || e.endIndex != 4) {
+			FAIL;
+		}
+		if (e.Message() != "Bad input for `-x' at index 3: `-2' - negative") {
+			FAIL;
+		}
+
+		args.resize(2);
+		parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (!parseContext.Run(e) || sum != 2) {
+			FAIL;
+		}
+		return true;
+	}
+
+
+	bool TestCollectErrors ()
+	{
+		std::vector<int> seen;
+		Opts opts;
+		opts.AddOption("x", [&] (int value) {
+			seen.push_back(value);
+		});
+		opts.AddOption(Keyword("verbose", "v").Counted(), [&] (unsigned int verbosity) {
+			seen.push_back(static_cast<int>(verbosity));
+		});
+
+		std::vector<std::string> args;
+		args.push_back("-x");
+		args.push_back("1");
+		args.push_back("-x");
+		args.push_back("y");
+		args.push_back("--verbose");
+		args.push_back("--what");
+		args.push_back("-v");
+		args.push_back("-x");
+		args.push_back("2");
+
+		std::vector<ParseFailedException> errors;
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (parseContext.Run(errors)) {
+			FAIL;
+		}
+		if (errors.size() != 2) {
+			FAIL;
+		}
+		if (errors[0].beginIndex != 2 || errors[0].endIndex != 4) {
+			FAIL;
+		}
+		if (errors[1].beginIndex != 5 || errors[1].endIndex != 6) {
+			FAIL;
+		}
+		if (seen.size() != 1 || seen[0] != 1) {
+			FAIL;
+		}
+
+		errors.clear();
+		args.erase(args.begin() + 5);
+		args.erase(args.begin() + 2, args.begin() + 4);
+		parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (!parseContext.Run(errors) || !errors.empty()) {
+			FAIL;
+		}
+		if (seen.size() != 4 || seen[1] != 1 || seen[2] != 2 || seen[3] != 2) {
+			FAIL;
+		}
+		return true;
+	}
+
+
+	bool TestLazy ()
+	{
+		bool converted = true;
+		Opts opts;
+		opts.AddOption("b", [&] (lambda_options::Lazy<bool> b) {
+			converted = b.TryGet() != nullptr;
+		});
+
+		// "fish" starts like "false", so it is only found to be bad when the value is read.
+		std::vector<std::string> args;
+		args.push_back("-b");
+		args.push_back("fish");
+
+		ParseFailedException e;
+		auto parseContext = opts.CreateParseContext(args.begin(), args.end());
+		if (!parseContext.Run(e) || converted) {
+			FAIL;
+		}
+		return true;
+	}
+}
+
+
+int main (int, char **)
+{
+	std::setlocale(LC_ALL, "C");
+
+	typedef bool (*TestFunc)();
+	TestFunc const tests[] = {
+		TestOptionErrors,
+		TestRun,
+		TestCollectErrors,
+		TestLazy,
+	};
+	for (TestFunc test : tests) {
+		if (!test()) {
+			return 1;
+		}
+	}
+	std::puts("All tests succeeded.");
+	return 0;
+}